@@ -0,0 +1,563 @@
+/*
+ * Benchmark harness for the embedding and parity stages. Each suite processes
+ * a batch of synthetic records whose sizes follow a log-uniform distribution,
+ * so a few large records dominate the tail as they do with real hotspots.
+ * Records are spread over OpenMP threads; every thread records per-record
+ * latency and size into its own histograms, which are merged at the end and
+ * printed as percentiles. Inputs are generated before each chunk of records is
+ * timed, and energy is read from RAPL around the stage calls only when the
+ * counters are accessible.
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <math.h>
+#include <omp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "embedding.h"
+#include "energy.h"
+#include "error_detection.h"
+#include "latency_histogram.h"
+
+#define PARITY_ROW_LENGTH 64
+#define MAX_SWEEP_POINTS 32
+/* Upper bound on the bytes of generated inputs held for one metered chunk. */
+#define SUITE_CHUNK_BYTES ((size_t)256 * 1024 * 1024)
+
+#ifndef DEFAULT_THREAD_COUNT
+#define DEFAULT_THREAD_COUNT 7
+#endif
+
+typedef struct {
+    size_t records;
+    size_t max_payload;
+    size_t max_rows;
+    int threads;
+    uint64_t seed;
+    int run_embedding;
+    int run_parity;
+    int sweep[MAX_SWEEP_POINTS];
+    size_t sweep_count;
+    const char *exec_command;
+    size_t exec_records;
+    size_t exec_bytes;
+} BenchOptions;
+
+/* Totals for one run, used for energy normalisation and sweep summaries. */
+typedef struct {
+    double seconds;
+    double joules;
+    size_t records;
+    size_t bytes;
+} RunReport;
+
+typedef struct {
+    LatencyHistogram latency;
+    LatencyHistogram size;
+    size_t bytes;
+    int failed;
+} SuiteHistograms;
+
+/*
+ * One benchmarked stage. `prepare` generates the input of a record and `run`
+ * times the stage on it, so generation stays out of the latency samples and
+ * the energy window. `footprint` predicts the bytes `prepare` allocates and
+ * bounds how many inputs are generated ahead of a metered chunk.
+ */
+typedef struct {
+    const char *name;
+    size_t (*footprint)(size_t index, const BenchOptions *options);
+    void *(*prepare)(size_t index, const BenchOptions *options);
+    int (*run)(void *input, uint64_t *elapsed_ns, size_t *size);
+    void (*release)(void *input);
+} BenchSuite;
+
+/* xorshift64* seeded per record, so results do not depend on thread count. */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t record_seed(const BenchOptions *options, size_t index) {
+    uint64_t state = options->seed ^ (0x9E3779B97F4A7C15ULL * (index + 1));
+    return state ? state : 1;
+}
+
+static size_t log_uniform(uint64_t *state, size_t min, size_t max) {
+    double unit = (double)(next_random(state) >> 11) / (double)(1ULL << 53);
+    double value = exp(log((double)min) + unit * (log((double)max) - log((double)min)));
+    size_t result = (size_t)value;
+    return result < min ? min : (result > max ? max : result);
+}
+
+static void fill_bases(uint64_t *state, char *bases, size_t length, const char alphabet[4]) {
+    for (size_t i = 0; i < length; ++i) {
+        bases[i] = alphabet[next_random(state) & 3];
+    }
+    bases[length] = '\0';
+}
+
+/* Input of one embedding call: a random sequence with one candidate per base. */
+typedef struct {
+    char *sequence;
+    CandidateSNP *candidates;
+    uint8_t *payload;
+    size_t payload_len;
+} EmbeddingInput;
+
+static size_t embedding_payload_len(size_t index, const BenchOptions *options) {
+    uint64_t state = record_seed(options, index);
+    return log_uniform(&state, 16, options->max_payload);
+}
+
+static size_t embedding_footprint(size_t index, const BenchOptions *options) {
+    size_t payload_len = embedding_payload_len(index, options);
+    return payload_len * (1 + 8 * (1 + sizeof(CandidateSNP)));
+}
+
+static void embedding_release(void *input) {
+    EmbeddingInput *embedding = (EmbeddingInput *)input;
+    if (!embedding) {
+        return;
+    }
+    free(embedding->sequence);
+    free(embedding->candidates);
+    free(embedding->payload);
+    free(embedding);
+}
+
+static void *embedding_prepare(size_t index, const BenchOptions *options) {
+    static const char alphabet[4] = {'A', 'C', 'G', 'T'};
+    uint64_t state = record_seed(options, index);
+    size_t payload_len = log_uniform(&state, 16, options->max_payload);
+    size_t bases = payload_len * 8;
+    EmbeddingInput *input = (EmbeddingInput *)calloc(1, sizeof(EmbeddingInput));
+    if (!input) {
+        return NULL;
+    }
+    input->sequence = (char *)malloc(bases + 1);
+    input->candidates = (CandidateSNP *)malloc(bases * sizeof(CandidateSNP));
+    input->payload = (uint8_t *)malloc(payload_len);
+    input->payload_len = payload_len;
+    if (!input->sequence || !input->candidates || !input->payload) {
+        embedding_release(input);
+        return NULL;
+    }
+    fill_bases(&state, input->sequence, bases, alphabet);
+    for (size_t i = 0; i < bases; ++i) {
+        input->candidates[i].position = i;
+        input->candidates[i].reference = input->sequence[i];
+        input->candidates[i].alternates = NULL;
+        input->candidates[i].num_alternates = 0;
+    }
+    for (size_t i = 0; i < payload_len; ++i) {
+        input->payload[i] = (uint8_t)next_random(&state);
+    }
+    return input;
+}
+
+/* One embedding call on a prepared sequence. */
+static int embedding_run(void *input, uint64_t *elapsed_ns, size_t *size) {
+    const EmbeddingInput *embedding = (const EmbeddingInput *)input;
+    EmbeddingResult result;
+    char *error = NULL;
+    uint64_t started = latency_now_ns();
+    int status = embed_bitstream(embedding->sequence, embedding->candidates, embedding->payload_len * 8,
+                                 embedding->payload, embedding->payload_len, &result, &error);
+    *elapsed_ns = latency_now_ns() - started;
+    *size = embedding->payload_len;
+
+    if (status == 0) {
+        free_embedding_result(&result);
+    }
+    free(error);
+    return status;
+}
+
+/* Input of one parity round trip: random rows and the base to corrupt. */
+typedef struct {
+    char *storage;
+    const char **words;
+    size_t rows;
+    size_t mutated_row;
+    size_t mutated_col;
+} ParityInput;
+
+static size_t parity_rows(size_t index, const BenchOptions *options) {
+    uint64_t state = record_seed(options, index);
+    return log_uniform(&state, 2, options->max_rows);
+}
+
+static size_t parity_footprint(size_t index, const BenchOptions *options) {
+    return parity_rows(index, options) * (PARITY_ROW_LENGTH + 1 + sizeof(char *));
+}
+
+static void parity_release(void *input) {
+    ParityInput *parity = (ParityInput *)input;
+    if (!parity) {
+        return;
+    }
+    free(parity->storage);
+    free((void *)parity->words);
+    free(parity);
+}
+
+static void *parity_prepare(size_t index, const BenchOptions *options) {
+    static const char alphabet[4] = {DNA_BASE_A, DNA_BASE_T, DNA_BASE_G, DNA_BASE_C};
+    uint64_t state = record_seed(options, index);
+    size_t rows = log_uniform(&state, 2, options->max_rows);
+    ParityInput *input = (ParityInput *)calloc(1, sizeof(ParityInput));
+    if (!input) {
+        return NULL;
+    }
+    input->storage = (char *)malloc(rows * (PARITY_ROW_LENGTH + 1));
+    input->words = (const char **)malloc(rows * sizeof(char *));
+    input->rows = rows;
+    if (!input->storage || !input->words) {
+        parity_release(input);
+        return NULL;
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        fill_bases(&state, input->storage + i * (PARITY_ROW_LENGTH + 1), PARITY_ROW_LENGTH, alphabet);
+        input->words[i] = input->storage + i * (PARITY_ROW_LENGTH + 1);
+    }
+    input->mutated_row = (size_t)(next_random(&state) % rows);
+    input->mutated_col = (size_t)(next_random(&state) % PARITY_ROW_LENGTH);
+    return input;
+}
+
+/* Builds a parity block, corrupts one base and checks that it is corrected. */
+static int parity_run(void *input, uint64_t *elapsed_ns, size_t *size) {
+    const ParityInput *parity = (const ParityInput *)input;
+    size_t total_rows = 0;
+    size_t total_cols = 0;
+    uint64_t started = latency_now_ns();
+    char **block = build_parity_block(parity->words, parity->rows, &total_rows, &total_cols);
+    int status = -1;
+    if (block) {
+        char original = block[parity->mutated_row][parity->mutated_col];
+        block[parity->mutated_row][parity->mutated_col] = original == DNA_BASE_A ? DNA_BASE_C : DNA_BASE_A;
+        status = detect_and_correct_parity_block(block, total_rows, total_cols, NULL, NULL) == PARITY_CORRECTED &&
+                         block[parity->mutated_row][parity->mutated_col] == original
+                     ? 0
+                     : -1;
+    }
+    *elapsed_ns = latency_now_ns() - started;
+    *size = parity->rows * PARITY_ROW_LENGTH;
+
+    free_parity_block(block, total_rows);
+    return status;
+}
+
+static const BenchSuite EMBEDDING_SUITE = {"embedding", embedding_footprint, embedding_prepare, embedding_run,
+                                           embedding_release};
+static const BenchSuite PARITY_SUITE = {"parity", parity_footprint, parity_prepare, parity_run, parity_release};
+
+/* Prints joules per GB and per record, or notes that RAPL is unavailable. */
+static void print_energy(const RunReport *report) {
+    if (report->joules < 0) {
+        printf("  energy                 unavailable (no readable RAPL counters)\n");
+        return;
+    }
+    printf("  energy                 %.3f J, %.1f W avg", report->joules,
+           report->seconds > 0 ? report->joules / report->seconds : 0.0);
+    if (report->bytes > 0) {
+        printf(", %.2f J/GB", report->joules / ((double)report->bytes / 1e9));
+    }
+    if (report->records > 0) {
+        printf(", %.3f mJ/record", report->joules * 1e3 / (double)report->records);
+    }
+    printf("\n");
+}
+
+/*
+ * Runs the batch in chunks of at most SUITE_CHUNK_BYTES of generated input.
+ * Each chunk is prepared first; only its stage calls are timed and metered,
+ * and the chunk times and energies are summed.
+ */
+static int run_suite(const BenchSuite *suite, const BenchOptions *options, int threads, EnergyMeter *meter,
+                     RunReport *report) {
+    const char *name = suite->name;
+    SuiteHistograms *local = (SuiteHistograms *)calloc((size_t)threads, sizeof(SuiteHistograms));
+    void **inputs = (void **)calloc(options->records > 0 ? options->records : 1, sizeof(void *));
+    if (!local || !inputs) {
+        fprintf(stderr, "Failed to allocate histograms for %s.\n", name);
+        free(local);
+        free(inputs);
+        return -1;
+    }
+    for (int t = 0; t < threads; ++t) {
+        latency_histogram_init(&local[t].latency);
+        latency_histogram_init(&local[t].size);
+    }
+
+    double seconds = 0.0;
+    double joules = meter && meter->count > 0 ? 0.0 : -1.0;
+    size_t begin = 0;
+    while (begin < options->records) {
+        size_t end = begin;
+        size_t chunk_bytes = 0;
+        while (end < options->records && (end == begin || chunk_bytes < SUITE_CHUNK_BYTES)) {
+            chunk_bytes += suite->footprint(end, options);
+            end++;
+        }
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+        for (long index = (long)begin; index < (long)end; ++index) {
+            inputs[index] = suite->prepare((size_t)index, options);
+        }
+
+        energy_meter_start(meter);
+        uint64_t started = latency_now_ns();
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+        for (long index = (long)begin; index < (long)end; ++index) {
+            SuiteHistograms *mine = &local[omp_get_thread_num()];
+            uint64_t elapsed = 0;
+            size_t size = 0;
+            if (!inputs[index] || suite->run(inputs[index], &elapsed, &size) != 0) {
+                mine->failed = 1;
+                continue;
+            }
+            latency_histogram_record(&mine->latency, elapsed);
+            latency_histogram_record(&mine->size, size);
+            mine->bytes += size;
+        }
+        seconds += (double)(latency_now_ns() - started) / 1e9;
+        double chunk_joules = energy_meter_stop(meter);
+        joules = joules < 0 || chunk_joules < 0 ? -1.0 : joules + chunk_joules;
+
+        for (size_t i = begin; i < end; ++i) {
+            suite->release(inputs[i]);
+            inputs[i] = NULL;
+        }
+        begin = end;
+    }
+    free(inputs);
+
+    int failed = local[0].failed;
+    for (int t = 1; t < threads; ++t) {
+        latency_histogram_merge(&local[0].latency, &local[t].latency);
+        latency_histogram_merge(&local[0].size, &local[t].size);
+        local[0].bytes += local[t].bytes;
+        failed |= local[t].failed;
+    }
+
+    printf("== %s batch: %zu records, %d threads, %.3f s, %.1f MB/s ==\n", name, options->records, threads, seconds,
+           seconds > 0 ? (double)local[0].bytes / 1e6 / seconds : 0.0);
+    latency_histogram_print(stdout, "  latency", &local[0].latency, 1e-3, "us");
+    latency_histogram_print(stdout, "  size", &local[0].size, 1.0, "B");
+    report->seconds = seconds;
+    report->joules = joules;
+    report->records = options->records;
+    report->bytes = local[0].bytes;
+    print_energy(report);
+    if (failed) {
+        fprintf(stderr, "Some %s records failed.\n", name);
+    }
+    free(local);
+    return failed ? -1 : 0;
+}
+
+/* Times an external command, e.g. the encryptor, under the same energy meter. */
+static int run_exec(const BenchOptions *options, EnergyMeter *meter, RunReport *report) {
+    fflush(stdout);
+    energy_meter_start(meter);
+    uint64_t started = latency_now_ns();
+    int status = system(options->exec_command);
+    report->seconds = (double)(latency_now_ns() - started) / 1e9;
+    report->joules = energy_meter_stop(meter);
+    report->records = options->exec_records;
+    report->bytes = options->exec_bytes;
+    printf("== exec: %s ==\n  wall time              %.3f s\n", options->exec_command, report->seconds);
+    print_energy(report);
+    if (status != 0) {
+        fprintf(stderr, "Command exited with status %d.\n", status);
+        return -1;
+    }
+    return 0;
+}
+
+static int run_all(const BenchOptions *options, int threads, EnergyMeter *meter, RunReport *total) {
+    RunReport report = {0};
+    int status = 0;
+    total->seconds = 0;
+    total->joules = 0;
+    total->records = 0;
+    total->bytes = 0;
+    if (options->run_embedding) {
+        status |= run_suite(&EMBEDDING_SUITE, options, threads, meter, &report);
+        total->seconds += report.seconds;
+        total->joules += report.joules;
+        total->records += report.records;
+        total->bytes += report.bytes;
+    }
+    if (options->run_parity) {
+        status |= run_suite(&PARITY_SUITE, options, threads, meter, &report);
+        total->seconds += report.seconds;
+        total->joules += report.joules;
+        total->records += report.records;
+        total->bytes += report.bytes;
+    }
+    if (meter->count == 0) {
+        total->joules = -1.0;
+    }
+    return status;
+}
+
+/*
+ * Runs the selected suites once per thread count and reports which count
+ * needs the least energy per record, the figure to build defaults from.
+ */
+static int run_sweep(const BenchOptions *options, EnergyMeter *meter) {
+    RunReport reports[MAX_SWEEP_POINTS];
+    int status = 0;
+    for (size_t i = 0; i < options->sweep_count; ++i) {
+        status |= run_all(options, options->sweep[i], meter, &reports[i]);
+    }
+
+    printf("== thread sweep ==\n  threads  seconds   joules   mJ/record\n");
+    size_t best = options->sweep_count;
+    for (size_t i = 0; i < options->sweep_count; ++i) {
+        const RunReport *report = &reports[i];
+        if (report->joules < 0) {
+            printf("  %7d  %7.3f        -           -\n", options->sweep[i], report->seconds);
+            continue;
+        }
+        printf("  %7d  %7.3f  %7.3f  %10.3f\n", options->sweep[i], report->seconds, report->joules,
+               report->records ? report->joules * 1e3 / (double)report->records : 0.0);
+        if (best == options->sweep_count || report->joules < reports[best].joules) {
+            best = i;
+        }
+    }
+    if (best < options->sweep_count) {
+        printf("Most energy-efficient: %d threads (build with DEFAULT_THREADS=%d).\n", options->sweep[best],
+               options->sweep[best]);
+    } else {
+        printf("Energy counters unavailable; no thread-count recommendation.\n");
+    }
+    return status;
+}
+
+static int parse_sweep(const char *list, BenchOptions *options) {
+    char *copy = strdup(list);
+    if (!copy) {
+        return -1;
+    }
+    options->sweep_count = 0;
+    for (char *token = strtok(copy, ","); token; token = strtok(NULL, ",")) {
+        int threads = atoi(token);
+        if (threads <= 0 || options->sweep_count == MAX_SWEEP_POINTS) {
+            free(copy);
+            return -1;
+        }
+        options->sweep[options->sweep_count++] = threads;
+    }
+    free(copy);
+    return options->sweep_count > 0 ? 0 : -1;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--suite embedding|parity|all] [--records N] [--max-payload BYTES] [--max-rows N]\n"
+            "          [--threads N] [--seed N] [--thread-sweep N,N,...]\n"
+            "          [--exec COMMAND [--exec-records N] [--exec-bytes N]]\n",
+            program);
+}
+
+static int parse_arguments(int argc, char **argv, BenchOptions *options) {
+    options->records = 2000;
+    options->max_payload = 65536;
+    options->max_rows = 4096;
+    options->threads = DEFAULT_THREAD_COUNT;
+    options->seed = 6010;
+    options->run_embedding = 1;
+    options->run_parity = 1;
+    options->sweep_count = 0;
+    options->exec_command = NULL;
+    options->exec_records = 0;
+    options->exec_bytes = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--suite") == 0 && i + 1 < argc) {
+            const char *suite = argv[++i];
+            options->run_embedding = strcmp(suite, "embedding") == 0 || strcmp(suite, "all") == 0;
+            options->run_parity = strcmp(suite, "parity") == 0 || strcmp(suite, "all") == 0;
+            if (!options->run_embedding && !options->run_parity) {
+                fprintf(stderr, "Unknown suite: %s\n", suite);
+                return -1;
+            }
+        } else if (strcmp(arg, "--records") == 0 && i + 1 < argc) {
+            options->records = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--max-payload") == 0 && i + 1 < argc) {
+            options->max_payload = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--max-rows") == 0 && i + 1 < argc) {
+            options->max_rows = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--thread-sweep") == 0 && i + 1 < argc) {
+            if (parse_sweep(argv[++i], options) != 0) {
+                fprintf(stderr, "Invalid thread list: %s\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(arg, "--exec") == 0 && i + 1 < argc) {
+            options->exec_command = argv[++i];
+        } else if (strcmp(arg, "--exec-records") == 0 && i + 1 < argc) {
+            options->exec_records = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--exec-bytes") == 0 && i + 1 < argc) {
+            options->exec_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    if (options->threads <= 0) {
+        options->threads = DEFAULT_THREAD_COUNT;
+    }
+    if (options->max_payload < 16) {
+        options->max_payload = 16;
+    }
+    if (options->max_rows < 2) {
+        options->max_rows = 2;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    int arg_status = parse_arguments(argc, argv, &options);
+    if (arg_status != 0) {
+        return arg_status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    EnergyMeter meter;
+    if (energy_meter_init(&meter) == 0) {
+        fprintf(stderr, "RAPL energy counters unavailable; reporting time only.\n");
+    }
+
+    RunReport report;
+    int status = 0;
+    if (options.exec_command) {
+        status = run_exec(&options, &meter, &report);
+    } else if (options.sweep_count > 0) {
+        status = run_sweep(&options, &meter);
+    } else {
+        status = run_all(&options, options.threads, &meter, &report);
+    }
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,118 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "energy.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef POWERCAP_ROOT
+#define POWERCAP_ROOT "/sys/class/powercap"
+#endif
+
+static int read_counter(const char *directory, const char *name, uint64_t *value) {
+    char path[ENERGY_PATH_LENGTH + 32];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    unsigned long long parsed = 0;
+    int matched = fscanf(file, "%llu", &parsed);
+    fclose(file);
+    if (matched != 1) {
+        return -1;
+    }
+    *value = (uint64_t)parsed;
+    return 0;
+}
+
+/* Returns 1 when the zone's `name` file starts with `prefix`. */
+static int zone_name_matches(const char *directory, const char *prefix) {
+    char path[ENERGY_PATH_LENGTH + 32];
+    snprintf(path, sizeof(path), "%s/name", directory);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+    char name[64];
+    int read = fgets(name, sizeof(name), file) != NULL;
+    fclose(file);
+    return read && strncmp(name, prefix, strlen(prefix)) == 0;
+}
+
+/*
+ * Package zones are the top-level "intel-rapl:<n>" directories (also used for
+ * AMD). "intel-rapl-mmio:<n>" mirrors the same package counter and "psys"
+ * covers the whole platform, so summing either with the packages would count
+ * energy twice; only zones whose name is "package-<n>" are kept.
+ */
+static int is_package_zone(const char *entry) {
+    static const char prefix[] = "intel-rapl:";
+    return strncmp(entry, prefix, sizeof(prefix) - 1) == 0 && !strchr(entry + sizeof(prefix) - 1, ':');
+}
+
+size_t energy_meter_init(EnergyMeter *meter) {
+    if (!meter) {
+        return 0;
+    }
+    meter->count = 0;
+    DIR *root = opendir(POWERCAP_ROOT);
+    if (!root) {
+        return 0;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(root)) != NULL && meter->count < ENERGY_MAX_DOMAINS) {
+        if (!is_package_zone(entry->d_name) ||
+            strlen(POWERCAP_ROOT) + 1 + strlen(entry->d_name) >= ENERGY_PATH_LENGTH) {
+            continue;
+        }
+        char *directory = meter->paths[meter->count];
+        strcpy(directory, POWERCAP_ROOT "/");
+        strcat(directory, entry->d_name);
+        if (!zone_name_matches(directory, "package-")) {
+            continue;
+        }
+        uint64_t energy = 0;
+        uint64_t range = 0;
+        /* energy_uj is usually root-only; unreadable zones are skipped. */
+        if (read_counter(directory, "energy_uj", &energy) != 0 ||
+            read_counter(directory, "max_energy_range_uj", &range) != 0) {
+            continue;
+        }
+        meter->max_range[meter->count] = range;
+        meter->count++;
+    }
+    closedir(root);
+    return meter->count;
+}
+
+void energy_meter_start(EnergyMeter *meter) {
+    if (!meter) {
+        return;
+    }
+    for (size_t i = 0; i < meter->count; ++i) {
+        if (read_counter(meter->paths[i], "energy_uj", &meter->start[i]) != 0) {
+            meter->start[i] = 0;
+        }
+    }
+}
+
+double energy_meter_stop(const EnergyMeter *meter) {
+    if (!meter || meter->count == 0) {
+        return -1.0;
+    }
+    uint64_t total = 0;
+    for (size_t i = 0; i < meter->count; ++i) {
+        uint64_t now = 0;
+        if (read_counter(meter->paths[i], "energy_uj", &now) != 0) {
+            return -1.0;
+        }
+        /* Counters wrap at max_energy_range_uj. */
+        total += now >= meter->start[i] ? now - meter->start[i] : meter->max_range[i] - meter->start[i] + now + 1;
+    }
+    return (double)total / 1e6;
+}
@@ -0,0 +1,30 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ENERGY_MAX_DOMAINS 16
+#define ENERGY_PATH_LENGTH 256
+
+/*
+ * Package-level energy counters from Linux powercap (RAPL). Only top-level
+ * domains such as intel-rapl:0 are read, so sub-domains (core, uncore, dram
+ * inside a package) are not double counted.
+ */
+typedef struct {
+    size_t count;
+    char paths[ENERGY_MAX_DOMAINS][ENERGY_PATH_LENGTH];
+    uint64_t max_range[ENERGY_MAX_DOMAINS];
+    uint64_t start[ENERGY_MAX_DOMAINS];
+} EnergyMeter;
+
+/* Discovers readable domains. Returns the number found; 0 means unavailable. */
+size_t energy_meter_init(EnergyMeter *meter);
+
+void energy_meter_start(EnergyMeter *meter);
+
+/* Joules consumed since energy_meter_start, or a negative value when unavailable. */
+double energy_meter_stop(const EnergyMeter *meter);
+
+#endif /* ENERGY_H */
@@ -0,0 +1,649 @@
+/*
+ * Replays a workload trace captured with `dna_hotspot_encryptor --capture-trace`.
+ * The trace holds only the shape of a production run, so this tool
+ * regenerates an input TSV with the same record count, field lengths, column
+ * presence and interval order, a reference FASTA that reproduces the same
+ * elision decisions, and a random key. It then runs the encryptor with the
+ * captured options under the energy meter, capturing a second trace, and
+ * compares per-stage latency percentiles of the two runs.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "energy.h"
+#include "latency_histogram.h"
+
+#define TRACE_ABSENT (-1L)
+#define FASTA_LINE_BASES 60
+#define COMMAND_LENGTH 8192
+
+typedef struct {
+    long id_len;
+    long positions_len;
+    long reference_len;
+    long sequence_len;
+    long contig;
+    long start_rank;
+    long interval_len;
+    int elided;
+    int thread;
+    uint64_t start_ns;
+    uint64_t plaintext_ns;
+    uint64_t cipher_ns;
+    uint64_t encode_ns;
+    size_t plaintext_bytes;
+} TraceRecord;
+
+typedef struct {
+    int threads;
+    char sort_by[32];
+    size_t sort_memory_mb;
+    int reference_fasta;
+    int latency_report;
+    uint64_t load_ns;
+    uint64_t run_ns;
+    TraceRecord *records;
+    size_t count;
+    size_t capacity;
+} WorkloadTrace;
+
+typedef struct {
+    const char *trace_path;
+    const char *encryptor;
+    const char *workdir;
+    int threads;
+    uint64_t seed;
+    int generate_only;
+} ReplayOptions;
+
+/* xorshift64*, the same generator the benchmark harness uses. */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t stream_seed(uint64_t seed, uint64_t stream, size_t index) {
+    uint64_t state = seed ^ (0x9E3779B97F4A7C15ULL * (index + 1)) ^ (stream << 56);
+    return state ? state : 1;
+}
+
+static void random_bases(char *out, size_t length, uint64_t *state) {
+    static const char bases[4] = {'A', 'C', 'G', 'T'};
+    for (size_t i = 0; i < length; ++i) {
+        out[i] = bases[next_random(state) >> 62];
+    }
+}
+
+static long parse_length(const char *field) {
+    if (!field || strcmp(field, "-") == 0) {
+        return TRACE_ABSENT;
+    }
+    return (long)strtol(field, NULL, 10);
+}
+
+static void trace_free(WorkloadTrace *trace) {
+    free(trace->records);
+    trace->records = NULL;
+    trace->count = 0;
+    trace->capacity = 0;
+}
+
+static int trace_append(WorkloadTrace *trace, const TraceRecord *record) {
+    if (trace->count == trace->capacity) {
+        size_t new_capacity = trace->capacity == 0 ? 1024 : trace->capacity * 2;
+        TraceRecord *resized = (TraceRecord *)realloc(trace->records, new_capacity * sizeof(TraceRecord));
+        if (!resized) {
+            return -1;
+        }
+        trace->records = resized;
+        trace->capacity = new_capacity;
+    }
+    trace->records[trace->count++] = *record;
+    return 0;
+}
+
+static int trace_read(const char *path, WorkloadTrace *trace) {
+    memset(trace, 0, sizeof(*trace));
+    strcpy(trace->sort_by, "none");
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open trace %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char *line = NULL;
+    size_t size = 0;
+    int status = 0;
+    int versioned = 0;
+    while (status == 0 && getline(&line, &size, file) >= 0) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *fields[16];
+        size_t count = 0;
+        char *save = NULL;
+        for (char *token = strtok_r(line, "\t", &save); token && count < 16; token = strtok_r(NULL, "\t", &save)) {
+            fields[count++] = token;
+        }
+        if (count == 0) {
+            continue;
+        }
+        if (strcmp(fields[0], "#workload-trace") == 0) {
+            versioned = count > 1 && atoi(fields[1]) == 2;
+        } else if (fields[0][0] == '#') {
+            continue;
+        } else if (strcmp(fields[0], "option") == 0 && count == 3) {
+            if (strcmp(fields[1], "threads") == 0) {
+                trace->threads = atoi(fields[2]);
+            } else if (strcmp(fields[1], "sort_by") == 0) {
+                snprintf(trace->sort_by, sizeof(trace->sort_by), "%s", fields[2]);
+            } else if (strcmp(fields[1], "sort_memory_mb") == 0) {
+                trace->sort_memory_mb = (size_t)strtoull(fields[2], NULL, 10);
+            } else if (strcmp(fields[1], "reference_fasta") == 0) {
+                trace->reference_fasta = atoi(fields[2]);
+            } else if (strcmp(fields[1], "latency_report") == 0) {
+                trace->latency_report = atoi(fields[2]);
+            }
+        } else if (strcmp(fields[0], "phase") == 0 && count == 3) {
+            if (strcmp(fields[1], "load_ns") == 0) {
+                trace->load_ns = strtoull(fields[2], NULL, 10);
+            } else if (strcmp(fields[1], "run_ns") == 0) {
+                trace->run_ns = strtoull(fields[2], NULL, 10);
+            }
+        } else if (strcmp(fields[0], "record") == 0 && count == 15) {
+            TraceRecord record;
+            record.id_len = parse_length(fields[1]);
+            record.positions_len = parse_length(fields[2]);
+            record.reference_len = parse_length(fields[3]);
+            record.sequence_len = parse_length(fields[4]);
+            record.contig = parse_length(fields[5]);
+            record.start_rank = parse_length(fields[6]);
+            record.interval_len = parse_length(fields[7]);
+            record.elided = atoi(fields[8]);
+            record.thread = atoi(fields[9]);
+            record.start_ns = strtoull(fields[10], NULL, 10);
+            record.plaintext_ns = strtoull(fields[11], NULL, 10);
+            record.cipher_ns = strtoull(fields[12], NULL, 10);
+            record.encode_ns = strtoull(fields[13], NULL, 10);
+            record.plaintext_bytes = (size_t)strtoull(fields[14], NULL, 10);
+            status = trace_append(trace, &record);
+        } else {
+            fprintf(stderr, "Unrecognised trace line in %s: %s\n", path, fields[0]);
+            status = -1;
+        }
+    }
+    free(line);
+    fclose(file);
+    if (status == 0 && !versioned) {
+        fprintf(stderr, "%s is not a version 2 workload trace.\n", path);
+        status = -1;
+    }
+    if (status == 0 && trace->count == 0) {
+        fprintf(stderr, "Trace %s contains no records.\n", path);
+        status = -1;
+    }
+    if (status != 0) {
+        trace_free(trace);
+    }
+    return status;
+}
+
+/*
+ * Synthetic contigs, one per captured contig rank. A record's interval starts
+ * at its captured start rank, so --sort-by chromosome orders the replayed
+ * records as it did the captured ones, and elided records copy their reference
+ * bases from that offset. Names are zero-padded to `name_width` digits so that
+ * their string order matches the rank order.
+ */
+typedef struct {
+    char **bases;
+    size_t *lengths;
+    size_t count;
+    int name_width;
+} SyntheticGenome;
+
+/* Offset of a record's interval in its synthetic contig. */
+static size_t interval_start(const TraceRecord *record) {
+    return record->start_rank > 0 ? (size_t)record->start_rank : 0;
+}
+
+static void genome_free(SyntheticGenome *genome) {
+    for (size_t i = 0; genome->bases && i < genome->count; ++i) {
+        free(genome->bases[i]);
+    }
+    free(genome->bases);
+    free(genome->lengths);
+    genome->bases = NULL;
+    genome->lengths = NULL;
+    genome->count = 0;
+}
+
+static int genome_build(const WorkloadTrace *trace, uint64_t seed, SyntheticGenome *genome) {
+    genome->count = 1;
+    for (size_t i = 0; i < trace->count; ++i) {
+        if (trace->records[i].contig >= 0 && (size_t)trace->records[i].contig + 1 > genome->count) {
+            genome->count = (size_t)trace->records[i].contig + 1;
+        }
+    }
+    genome->bases = (char **)calloc(genome->count, sizeof(char *));
+    genome->lengths = (size_t *)calloc(genome->count, sizeof(size_t));
+    if (!genome->bases || !genome->lengths) {
+        genome_free(genome);
+        return -1;
+    }
+    for (size_t i = 0; i < trace->count; ++i) {
+        const TraceRecord *record = &trace->records[i];
+        if (record->contig >= 0 && record->interval_len > 0 &&
+            interval_start(record) + (size_t)record->interval_len > genome->lengths[record->contig]) {
+            genome->lengths[record->contig] = interval_start(record) + (size_t)record->interval_len;
+        }
+    }
+    genome->name_width = 1;
+    for (size_t last = genome->count - 1; last >= 10; last /= 10) {
+        genome->name_width++;
+    }
+    for (size_t c = 0; c < genome->count; ++c) {
+        uint64_t state = stream_seed(seed, 1, c);
+        if (genome->lengths[c] == 0) {
+            genome->lengths[c] = FASTA_LINE_BASES;
+        }
+        genome->bases[c] = (char *)malloc(genome->lengths[c]);
+        if (!genome->bases[c]) {
+            genome_free(genome);
+            return -1;
+        }
+        random_bases(genome->bases[c], genome->lengths[c], &state);
+    }
+    return 0;
+}
+
+static int write_reference(const char *path, const SyntheticGenome *genome) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (size_t c = 0; c < genome->count; ++c) {
+        fprintf(file, ">c%0*zu\n", genome->name_width, c);
+        for (size_t offset = 0; offset < genome->lengths[c]; offset += FASTA_LINE_BASES) {
+            size_t line = genome->lengths[c] - offset < FASTA_LINE_BASES ? genome->lengths[c] - offset
+                                                                         : FASTA_LINE_BASES;
+            fwrite(genome->bases[c] + offset, 1, line, file);
+            fputc('\n', file);
+        }
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+/*
+ * Writes one synthetic row. Columns are ordered so that fields missing from a
+ * captured record can be left off the end of the row; only a missing
+ * positions field followed by a present reference is replayed as empty.
+ */
+static int write_row(FILE *file, const TraceRecord *record, size_t index, uint64_t seed,
+                     const SyntheticGenome *genome, int has_interval, int has_positions, int has_reference,
+                     char *buffer) {
+    static const char id_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_";
+    uint64_t state = stream_seed(seed, 2, index);
+    size_t id_len = record->id_len > 0 ? (size_t)record->id_len : 1;
+    for (size_t i = 0; i < id_len; ++i) {
+        buffer[i] = id_alphabet[next_random(&state) % (sizeof(id_alphabet) - 1)];
+    }
+    fwrite(buffer, 1, id_len, file);
+
+    size_t sequence_len = record->sequence_len > 0 ? (size_t)record->sequence_len : 1;
+    random_bases(buffer, sequence_len, &state);
+    fputc('\t', file);
+    fwrite(buffer, 1, sequence_len, file);
+
+    int positions = has_positions && record->positions_len != TRACE_ABSENT;
+    int reference = has_reference && record->reference_len != TRACE_ABSENT;
+    if (has_interval && (record->contig >= 0 || positions || reference)) {
+        if (record->contig >= 0) {
+            /* A zero interval length is a row with a start but no end; it still sorts by contig. */
+            size_t start = interval_start(record);
+            size_t length = record->interval_len > 0 ? (size_t)record->interval_len : 0;
+            fprintf(file, "\tc%0*ld\t%zu\t%zu", genome->name_width, record->contig, start, start + length);
+        } else {
+            fputs("\t\t\t", file);
+        }
+    }
+    if (has_positions && (positions || reference)) {
+        size_t length = positions ? (size_t)record->positions_len : 0;
+        for (size_t i = 0; i < length; ++i) {
+            buffer[i] = (i % 7 == 6 && i + 1 < length) ? ',' : (char)('0' + next_random(&state) % 10);
+        }
+        fputc('\t', file);
+        fwrite(buffer, 1, length, file);
+    }
+    if (reference) {
+        size_t length = (size_t)record->reference_len;
+        if (record->elided && record->contig >= 0 && (long)length == record->interval_len) {
+            memcpy(buffer, genome->bases[record->contig] + interval_start(record), length);
+        } else {
+            random_bases(buffer, length, &state);
+            /* A non-elided record must not match the synthetic reference by chance. */
+            if (record->contig >= 0 && length > 0 && (long)length == record->interval_len &&
+                memcmp(buffer, genome->bases[record->contig] + interval_start(record), length) == 0) {
+                buffer[0] = buffer[0] == 'A' ? 'C' : 'A';
+            }
+        }
+        fputc('\t', file);
+        fwrite(buffer, 1, length, file);
+    }
+    return fputc('\n', file) == EOF ? -1 : 0;
+}
+
+static int write_input(const char *path, const WorkloadTrace *trace, uint64_t seed, const SyntheticGenome *genome) {
+    int has_interval = 0;
+    int has_positions = 0;
+    int has_reference = 0;
+    size_t longest = 1;
+    for (size_t i = 0; i < trace->count; ++i) {
+        const TraceRecord *record = &trace->records[i];
+        has_interval |= record->contig >= 0;
+        has_positions |= record->positions_len != TRACE_ABSENT;
+        has_reference |= record->reference_len != TRACE_ABSENT;
+        long lengths[4] = {record->id_len, record->positions_len, record->reference_len, record->sequence_len};
+        for (size_t k = 0; k < 4; ++k) {
+            if (lengths[k] > 0 && (size_t)lengths[k] > longest) {
+                longest = (size_t)lengths[k];
+            }
+        }
+    }
+    char *buffer = (char *)malloc(longest);
+    FILE *file = fopen(path, "w");
+    if (!buffer || !file) {
+        fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+        free(buffer);
+        if (file) {
+            fclose(file);
+        }
+        return -1;
+    }
+    fputs("record_id\thotspot_string", file);
+    if (has_interval) {
+        fputs("\tchromosome\tstart\tend", file);
+    }
+    if (has_positions) {
+        fputs("\thotspot_positions", file);
+    }
+    if (has_reference) {
+        fputs("\treference", file);
+    }
+    fputc('\n', file);
+    int status = 0;
+    for (size_t i = 0; i < trace->count && status == 0; ++i) {
+        status = write_row(file, &trace->records[i], i, seed, genome, has_interval, has_positions, has_reference,
+                           buffer);
+    }
+    free(buffer);
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+static int write_key(const char *path, uint64_t seed) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    uint64_t state = stream_seed(seed, 3, 0);
+    for (int i = 0; i < 4; ++i) {
+        fprintf(file, "%016llx", (unsigned long long)next_random(&state));
+    }
+    fputc('\n', file);
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+/* Per-stage histograms of a trace, in the order printed by compare_traces. */
+typedef struct {
+    LatencyHistogram stages[4];
+    LatencyHistogram plaintext_bytes;
+    size_t bytes;
+    size_t elided;
+} TraceSummary;
+
+static void summarise(const WorkloadTrace *trace, TraceSummary *summary) {
+    for (size_t k = 0; k < 4; ++k) {
+        latency_histogram_init(&summary->stages[k]);
+    }
+    latency_histogram_init(&summary->plaintext_bytes);
+    summary->bytes = 0;
+    summary->elided = 0;
+    for (size_t i = 0; i < trace->count; ++i) {
+        const TraceRecord *record = &trace->records[i];
+        latency_histogram_record(&summary->stages[0], record->plaintext_ns);
+        latency_histogram_record(&summary->stages[1], record->cipher_ns);
+        latency_histogram_record(&summary->stages[2], record->encode_ns);
+        latency_histogram_record(&summary->stages[3], record->plaintext_ns + record->cipher_ns + record->encode_ns);
+        latency_histogram_record(&summary->plaintext_bytes, record->plaintext_bytes);
+        summary->bytes += record->plaintext_bytes;
+        summary->elided += (size_t)record->elided;
+    }
+}
+
+static void compare_traces(const WorkloadTrace *captured, const WorkloadTrace *replayed) {
+    static const char *labels[4] = {"build_plaintext", "xchacha20", "dna_encode", "record_total"};
+    TraceSummary *summaries = (TraceSummary *)malloc(2 * sizeof(TraceSummary));
+    if (!summaries) {
+        return;
+    }
+    summarise(captured, &summaries[0]);
+    summarise(replayed, &summaries[1]);
+    printf("== captured vs replayed ==\n");
+    printf("  records                %zu / %zu\n", captured->count, replayed->count);
+    printf("  plaintext bytes        %zu / %zu\n", summaries[0].bytes, summaries[1].bytes);
+    printf("  elided records         %zu / %zu\n", summaries[0].elided, summaries[1].elided);
+    printf("  load                   %.3f / %.3f s\n", (double)captured->load_ns / 1e9,
+           (double)replayed->load_ns / 1e9);
+    printf("  run                    %.3f / %.3f s\n", (double)captured->run_ns / 1e9,
+           (double)replayed->run_ns / 1e9);
+    for (size_t k = 0; k < 4; ++k) {
+        char label[64];
+        snprintf(label, sizeof(label), "  %s captured", labels[k]);
+        latency_histogram_print(stdout, label, &summaries[0].stages[k], 1e-3, "us");
+        snprintf(label, sizeof(label), "  %s replayed", labels[k]);
+        latency_histogram_print(stdout, label, &summaries[1].stages[k], 1e-3, "us");
+    }
+    latency_histogram_print(stdout, "  plaintext captured", &summaries[0].plaintext_bytes, 1.0, "B");
+    latency_histogram_print(stdout, "  plaintext replayed", &summaries[1].plaintext_bytes, 1.0, "B");
+    /* Elided plaintexts name synthetic contigs and coordinates, so their sizes differ by a few bytes. */
+    if (captured->count != replayed->count || summaries[0].elided != summaries[1].elided) {
+        fprintf(stderr, "Replayed workload differs in shape from the capture.\n");
+    }
+    free(summaries);
+}
+
+static int build_command(char *command, size_t size, const ReplayOptions *options, const WorkloadTrace *trace,
+                         int threads) {
+    int written = snprintf(command, size,
+                           "'%s' --input '%s/input.tsv' --key '%s/key.hex' --output '%s/output.tsv' --threads %d"
+                           " --capture-trace '%s/replay.trace'",
+                           options->encryptor, options->workdir, options->workdir, options->workdir, threads,
+                           options->workdir);
+    if (written < 0 || (size_t)written >= size) {
+        return -1;
+    }
+    size_t used = (size_t)written;
+    if (strcmp(trace->sort_by, "none") != 0) {
+        written = snprintf(command + used, size - used, " --sort-by %s --sort-memory %zu", trace->sort_by,
+                           trace->sort_memory_mb);
+        if (written < 0 || (size_t)written >= size - used) {
+            return -1;
+        }
+        used += (size_t)written;
+    }
+    if (trace->reference_fasta) {
+        written = snprintf(command + used, size - used, " --reference-fasta '%s/reference.fa'", options->workdir);
+        if (written < 0 || (size_t)written >= size - used) {
+            return -1;
+        }
+        used += (size_t)written;
+    }
+    if (trace->latency_report) {
+        written = snprintf(command + used, size - used, " --latency-report");
+        if (written < 0 || (size_t)written >= size - used) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s --trace <capture.trace> [--encryptor PATH] [--workdir DIR] [--threads N] [--seed N]\n"
+            "          [--generate-only]\n",
+            program);
+}
+
+static int parse_arguments(int argc, char **argv, ReplayOptions *options) {
+    options->trace_path = NULL;
+    options->encryptor = "../encryption/dna_hotspot_encryptor";
+    options->workdir = NULL;
+    options->threads = 0;
+    options->seed = 6010;
+    options->generate_only = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            options->trace_path = argv[++i];
+        } else if (strcmp(arg, "--encryptor") == 0 && i + 1 < argc) {
+            options->encryptor = argv[++i];
+        } else if (strcmp(arg, "--workdir") == 0 && i + 1 < argc) {
+            options->workdir = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--generate-only") == 0) {
+            options->generate_only = 1;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", arg);
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    if (!options->trace_path) {
+        fprintf(stderr, "Missing required arguments.\n");
+        print_usage(argv[0]);
+        return -1;
+    }
+    if (strchr(options->encryptor, '\'') || (options->workdir && strchr(options->workdir, '\''))) {
+        fprintf(stderr, "Paths must not contain single quotes.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    ReplayOptions options;
+    int arg_status = parse_arguments(argc, argv, &options);
+    if (arg_status != 0) {
+        return arg_status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    WorkloadTrace captured;
+    if (trace_read(options.trace_path, &captured) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    char workdir_template[] = "/tmp/workload_replay.XXXXXX";
+    if (options.workdir && mkdir(options.workdir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s: %s\n", options.workdir, strerror(errno));
+        trace_free(&captured);
+        return EXIT_FAILURE;
+    }
+    if (!options.workdir) {
+        options.workdir = mkdtemp(workdir_template);
+        if (!options.workdir) {
+            fprintf(stderr, "Failed to create a working directory: %s\n", strerror(errno));
+            trace_free(&captured);
+            return EXIT_FAILURE;
+        }
+    }
+
+    char path[4096];
+    SyntheticGenome genome = {0};
+    int status = genome_build(&captured, options.seed, &genome);
+    if (status == 0 && captured.reference_fasta) {
+        snprintf(path, sizeof(path), "%s/reference.fa", options.workdir);
+        status = write_reference(path, &genome);
+    }
+    if (status == 0) {
+        snprintf(path, sizeof(path), "%s/input.tsv", options.workdir);
+        status = write_input(path, &captured, options.seed, &genome);
+    }
+    if (status == 0) {
+        snprintf(path, sizeof(path), "%s/key.hex", options.workdir);
+        status = write_key(path, options.seed);
+    }
+    genome_free(&genome);
+    if (status != 0) {
+        fprintf(stderr, "Failed to generate the replay inputs in %s.\n", options.workdir);
+        trace_free(&captured);
+        return EXIT_FAILURE;
+    }
+
+    int threads = options.threads > 0 ? options.threads : captured.threads;
+    char command[COMMAND_LENGTH];
+    if (build_command(command, sizeof(command), &options, &captured, threads) != 0) {
+        fprintf(stderr, "Replay command is too long.\n");
+        trace_free(&captured);
+        return EXIT_FAILURE;
+    }
+    printf("Replay inputs for %zu records written to %s.\n", captured.count, options.workdir);
+    if (options.generate_only) {
+        printf("%s\n", command);
+        trace_free(&captured);
+        return EXIT_SUCCESS;
+    }
+
+    EnergyMeter meter;
+    if (energy_meter_init(&meter) == 0) {
+        fprintf(stderr, "RAPL energy counters unavailable; reporting time only.\n");
+    }
+    fflush(stdout);
+    energy_meter_start(&meter);
+    uint64_t started = latency_now_ns();
+    int exit_code = system(command);
+    double seconds = (double)(latency_now_ns() - started) / 1e9;
+    double joules = energy_meter_stop(&meter);
+    printf("== replay: %zu records, %d threads, sort %s ==\n  wall time              %.3f s\n", captured.count,
+           threads, captured.sort_by, seconds);
+    if (joules >= 0) {
+        printf("  energy                 %.3f J (%.3f mJ/record)\n", joules, joules * 1e3 / (double)captured.count);
+    }
+    if (exit_code != 0) {
+        fprintf(stderr, "Encryptor exited with status %d.\n", exit_code);
+        trace_free(&captured);
+        return EXIT_FAILURE;
+    }
+
+    WorkloadTrace replayed;
+    snprintf(path, sizeof(path), "%s/replay.trace", options.workdir);
+    if (trace_read(path, &replayed) != 0) {
+        trace_free(&captured);
+        return EXIT_FAILURE;
+    }
+    compare_traces(&captured, &replayed);
+    trace_free(&replayed);
+    trace_free(&captured);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#ifndef DNA_TRANSFORM_H
+#define DNA_TRANSFORM_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fused per-base transforms. Instead of walking a buffer once to uppercase it,
+ * again to validate it, again to sum its digits and so on, a stage calls
+ * dna_fused_pass once with the set of operations it needs. The function is
+ * static inline and every operation is guarded by a test on `ops`, so when
+ * `ops` is a compile-time constant the compiler drops the unused operations
+ * and emits a single specialised loop. The loop has no early exit, which keeps
+ * it vectorisable; validation only reports whether any base was invalid.
+ */
+enum {
+    DNA_PASS_NORMALIZE = 1u << 0, /* Write upper-case bases to `bases`. */
+    DNA_PASS_VALIDATE = 1u << 1,  /* Fail when a base is not A/C/G/T (any case). */
+    DNA_PASS_CHECKSUM = 1u << 2,  /* Sum of digits into `checksum`; mod 4 gives block parity. */
+    DNA_PASS_COLUMNS = 1u << 3    /* Add digit i to `column_sums[i]`, accumulating across rows. */
+};
+
+/* Digit assignment for a stage: `codes` maps a byte to digit + 1 (0 = not a base). */
+typedef struct {
+    const unsigned char *codes;
+    const char *bases;
+} DnaAlphabet;
+
+/* A=0, T=1, G=2, C=3: digits of the block sum parity codec. */
+static const unsigned char DNA_CODES_ATGC[256] = {
+    ['A'] = 1, ['a'] = 1, ['T'] = 2, ['t'] = 2, ['G'] = 3, ['g'] = 3, ['C'] = 4, ['c'] = 4,
+};
+
+static const DnaAlphabet DNA_ALPHABET_ATGC = {DNA_CODES_ATGC, "ATGC"};
+
+typedef struct {
+    char *bases;         /* DNA_PASS_NORMALIZE output, `length` bytes. */
+    size_t *column_sums; /* DNA_PASS_COLUMNS accumulators, `length` entries. */
+    size_t checksum;     /* DNA_PASS_CHECKSUM result. */
+} DnaPassOutput;
+
+/*
+ * Runs the operations selected in `ops` over `input[0 .. length)` in one pass.
+ * Invalid bases count as digit 0. Returns 0, or -1 when DNA_PASS_VALIDATE is
+ * set and an invalid base was found; outputs are then only partially valid.
+ */
+static inline int dna_fused_pass(unsigned ops, const DnaAlphabet *alphabet, const char *input, size_t length,
+                                 DnaPassOutput *out) {
+    const unsigned char *codes = alphabet->codes;
+    size_t checksum = 0;
+    unsigned char invalid = 0;
+
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char code = codes[(unsigned char)input[i]];
+        unsigned digit = (unsigned)(code - (code != 0)) & 3u;
+        if (ops & DNA_PASS_VALIDATE) {
+            invalid |= (unsigned char)(code == 0);
+        }
+        if (ops & DNA_PASS_NORMALIZE) {
+            out->bases[i] = alphabet->bases[digit];
+        }
+        if (ops & DNA_PASS_CHECKSUM) {
+            checksum += digit;
+        }
+        if (ops & DNA_PASS_COLUMNS) {
+            out->column_sums[i] += digit;
+        }
+    }
+
+    if (ops & DNA_PASS_CHECKSUM) {
+        out->checksum = checksum;
+    }
+    return (ops & DNA_PASS_VALIDATE) && invalid ? -1 : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DNA_TRANSFORM_H */
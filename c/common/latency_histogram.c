@@ -0,0 +1,114 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "latency_histogram.h"
+
+#include <string.h>
+#include <time.h>
+
+static unsigned highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - (unsigned)__builtin_clzll(value);
+#else
+    unsigned bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static size_t bucket_index(uint64_t value) {
+    if (value < 2 * LATENCY_HISTOGRAM_HALF) {
+        return (size_t)value;
+    }
+    unsigned shift = highest_bit(value) - (LATENCY_HISTOGRAM_SUB_BITS - 1);
+    return (size_t)(shift + 1) * LATENCY_HISTOGRAM_HALF + (size_t)((value >> shift) - LATENCY_HISTOGRAM_HALF);
+}
+
+/* Largest value that maps to `index`, so percentiles never under-report. */
+static uint64_t bucket_upper_value(size_t index) {
+    if (index < 2 * LATENCY_HISTOGRAM_HALF) {
+        return (uint64_t)index;
+    }
+    unsigned shift = (unsigned)(index / LATENCY_HISTOGRAM_HALF) - 1;
+    uint64_t sub = (uint64_t)(index % LATENCY_HISTOGRAM_HALF) + LATENCY_HISTOGRAM_HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+void latency_histogram_init(LatencyHistogram *histogram) {
+    if (!histogram) {
+        return;
+    }
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    histogram->total = 0;
+    histogram->min = UINT64_MAX;
+    histogram->max = 0;
+}
+
+void latency_histogram_record(LatencyHistogram *histogram, uint64_t value) {
+    histogram->counts[bucket_index(value)]++;
+    histogram->total++;
+    if (value < histogram->min) {
+        histogram->min = value;
+    }
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+void latency_histogram_merge(LatencyHistogram *into, const LatencyHistogram *from) {
+    if (!into || !from) {
+        return;
+    }
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+    if (from->min < into->min) {
+        into->min = from->min;
+    }
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+uint64_t latency_histogram_percentile(const LatencyHistogram *histogram, double percentile) {
+    if (!histogram || histogram->total == 0) {
+        return 0;
+    }
+    if (percentile >= 100.0) {
+        return histogram->max;
+    }
+    uint64_t target = (uint64_t)((percentile / 100.0) * (double)histogram->total + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram->counts[i];
+        if (seen >= target) {
+            uint64_t value = bucket_upper_value(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void latency_histogram_print(FILE *stream, const char *label, const LatencyHistogram *histogram, double scale,
+                             const char *unit) {
+    if (!stream || !histogram) {
+        return;
+    }
+    fprintf(stream, "%-22s n=%-9llu p50=%.1f%s p99=%.1f%s p999=%.1f%s max=%.1f%s\n", label ? label : "",
+            (unsigned long long)histogram->total, latency_histogram_percentile(histogram, 50.0) * scale, unit,
+            latency_histogram_percentile(histogram, 99.0) * scale, unit,
+            latency_histogram_percentile(histogram, 99.9) * scale, unit, (double)histogram->max * scale, unit);
+}
+
+uint64_t latency_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
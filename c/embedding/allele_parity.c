@@ -0,0 +1,363 @@
+/*
+ * Parity protection for the embedded allele stream. Payload bits are arranged
+ * as rows of A (0) and T (1) nucleotides so the block sum parity codec from
+ * c/error_detection can be reused unchanged. Parity digits (0-3) are packed as
+ * two bits each and appended to the payload, so they are embedded into the
+ * candidates that follow the payload bits.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allele_parity.h"
+#include "error_detection.h"
+
+/* -- Internal helpers ----------------------------------------------------- */
+
+/* Parity digits produced by a full block; only the last block may be shorter. */
+#define BLOCK_PARITY_DIGITS (ALLELE_PARITY_BLOCK_ROWS + ALLELE_PARITY_ROW_BITS + 1)
+
+static int set_error(char **out_error, const char *message);
+static size_t row_count(size_t payload_len);
+static size_t block_count(size_t payload_len);
+static size_t rows_in_block(size_t payload_len, size_t block);
+static size_t parity_digit_count(size_t payload_len);
+static int get_bit(const uint8_t *data, size_t index);
+static void put_bit(uint8_t *data, size_t index, int bit);
+static int parity_digit(char base);
+static char parity_base(int digit);
+static const char *encode_block(const uint8_t *payload,
+                                size_t payload_len,
+                                size_t block,
+                                uint8_t *encoded,
+                                size_t digit_offset);
+static const char *decode_block(uint8_t *encoded,
+                                size_t payload_len,
+                                size_t block,
+                                size_t digit_offset,
+                                int *out_corrected);
+
+size_t allele_parity_encoded_length(size_t payload_len) {
+    return payload_len + (parity_digit_count(payload_len) * 2 + 7) / 8;
+}
+
+int embed_bitstream_protected(const char *sequence,
+                              const CandidateSNP *candidates,
+                              size_t num_candidates,
+                              const uint8_t *payload,
+                              size_t payload_len,
+                              const CandidatePermutation *permutation,
+                              int num_threads,
+                              EmbeddingResult *out_result,
+                              char **out_error) {
+    size_t encoded_len;
+    uint8_t *encoded;
+    size_t blocks;
+    size_t block;
+    int status;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+
+    if (payload_len > 0 && !payload) {
+        return set_error(out_error, "Invalid argument: payload data is NULL.");
+    }
+
+    encoded_len = allele_parity_encoded_length(payload_len);
+    encoded = (uint8_t *)calloc(encoded_len > 0 ? encoded_len : 1, 1);
+    if (!encoded) {
+        return set_error(out_error, "Failed to allocate memory for parity stream.");
+    }
+    if (payload_len > 0) {
+        memcpy(encoded, payload, payload_len);
+    }
+
+    blocks = block_count(payload_len);
+    for (block = 0; block < blocks; ++block) {
+        const char *message = encode_block(payload, payload_len, block, encoded,
+                                           block * BLOCK_PARITY_DIGITS);
+        if (message) {
+            free(encoded);
+            return set_error(out_error, message);
+        }
+    }
+
+    status = embed_bitstream_permuted(sequence, candidates, num_candidates, encoded, encoded_len,
+                                      permutation, num_threads, out_result, out_error);
+    free(encoded);
+    return status;
+}
+
+int extract_bitstream_protected(const char *sequence,
+                                const CandidateSNP *candidates,
+                                size_t num_candidates,
+                                const CandidatePermutation *permutation,
+                                uint8_t *out_payload,
+                                size_t payload_len,
+                                size_t *out_corrected,
+                                char **out_error) {
+    size_t encoded_len;
+    uint8_t *encoded;
+    size_t blocks;
+    size_t corrected = 0;
+    size_t error_block;
+    const char *error_message = NULL;
+    long index;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+    if (out_corrected) {
+        *out_corrected = 0;
+    }
+
+    if (payload_len > 0 && !out_payload) {
+        return set_error(out_error, "Invalid argument: NULL pointer supplied.");
+    }
+
+    encoded_len = allele_parity_encoded_length(payload_len);
+    encoded = (uint8_t *)calloc(encoded_len > 0 ? encoded_len : 1, 1);
+    if (!encoded) {
+        return set_error(out_error, "Failed to allocate memory for parity stream.");
+    }
+
+    if (extract_bitstream_tolerant(sequence, candidates, num_candidates, permutation,
+                                   encoded, encoded_len, NULL, out_error) != 0) {
+        free(encoded);
+        return -1;
+    }
+
+    /*
+     * Blocks cover whole rows of ALLELE_PARITY_ROW_BITS bits, so every block
+     * owns disjoint payload bytes and parity digits and can be decoded
+     * independently.
+     */
+    blocks = block_count(payload_len);
+    error_block = blocks;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+ : corrected) \
+    if (payload_len * 8 >= EMBED_PARALLEL_MIN_BITS)
+#endif
+    for (index = 0; index < (long)blocks; ++index) {
+        size_t block = (size_t)index;
+        size_t digit_offset = block * BLOCK_PARITY_DIGITS;
+        int block_corrected = 0;
+        const char *message = decode_block(encoded, payload_len, block, digit_offset, &block_corrected);
+
+        if (message) {
+#ifdef _OPENMP
+#pragma omp critical(allele_parity_error)
+#endif
+            {
+                if (block < error_block) {
+                    error_block = block;
+                    error_message = message;
+                }
+            }
+            continue;
+        }
+        corrected += (size_t)block_corrected;
+    }
+
+    if (error_message) {
+        free(encoded);
+        return set_error(out_error, error_message);
+    }
+
+    if (payload_len > 0) {
+        memcpy(out_payload, encoded, payload_len);
+    }
+    if (out_corrected) {
+        *out_corrected = corrected;
+    }
+    free(encoded);
+    return 0;
+}
+
+static int set_error(char **out_error, const char *message) {
+    if (out_error) {
+        size_t len = strlen(message);
+        char *copy = (char *)malloc(len + 1);
+        if (!copy) {
+            *out_error = NULL;
+            return -1;
+        }
+        memcpy(copy, message, len + 1);
+        *out_error = copy;
+    }
+    return -1;
+}
+
+static size_t row_count(size_t payload_len) {
+    return (payload_len * 8 + ALLELE_PARITY_ROW_BITS - 1) / ALLELE_PARITY_ROW_BITS;
+}
+
+static size_t block_count(size_t payload_len) {
+    return (row_count(payload_len) + ALLELE_PARITY_BLOCK_ROWS - 1) / ALLELE_PARITY_BLOCK_ROWS;
+}
+
+static size_t rows_in_block(size_t payload_len, size_t block) {
+    size_t remaining = row_count(payload_len) - block * ALLELE_PARITY_BLOCK_ROWS;
+    return remaining < ALLELE_PARITY_BLOCK_ROWS ? remaining : ALLELE_PARITY_BLOCK_ROWS;
+}
+
+/* One digit per data row plus a full parity row (columns and corner). */
+static size_t parity_digit_count(size_t payload_len) {
+    return row_count(payload_len) + block_count(payload_len) * (ALLELE_PARITY_ROW_BITS + 1);
+}
+
+static int get_bit(const uint8_t *data, size_t index) {
+    return (data[index / 8] >> (7 - (index % 8))) & 1;
+}
+
+static void put_bit(uint8_t *data, size_t index, int bit) {
+    uint8_t mask = (uint8_t)(1u << (7 - (index % 8)));
+    if (bit) {
+        data[index / 8] |= mask;
+    } else {
+        data[index / 8] &= (uint8_t)~mask;
+    }
+}
+
+/* Digit mapping used by the parity codec: A=0, T=1, G=2, C=3. */
+static int parity_digit(char base) {
+    switch (base) {
+        case DNA_BASE_A:
+            return 0;
+        case DNA_BASE_T:
+            return 1;
+        case DNA_BASE_G:
+            return 2;
+        case DNA_BASE_C:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+static char parity_base(int digit) {
+    static const char mapping[] = {DNA_BASE_A, DNA_BASE_T, DNA_BASE_G, DNA_BASE_C};
+    return mapping[digit & 3];
+}
+
+/*
+ * Builds the parity block for one group of rows and packs its parity digits
+ * into `encoded` after the payload bits. Bits beyond the payload read as 0.
+ */
+static const char *encode_block(const uint8_t *payload,
+                                size_t payload_len,
+                                size_t block,
+                                uint8_t *encoded,
+                                size_t digit_offset) {
+    char storage[ALLELE_PARITY_BLOCK_ROWS][ALLELE_PARITY_ROW_BITS + 1];
+    const char *rows[ALLELE_PARITY_BLOCK_ROWS];
+    size_t data_rows = rows_in_block(payload_len, block);
+    size_t bit_count = payload_len * 8;
+    size_t parity_start = bit_count;
+    size_t total_rows = 0;
+    size_t total_cols = 0;
+    size_t digit = digit_offset;
+    char **parity;
+    size_t r;
+    size_t c;
+
+    for (r = 0; r < data_rows; ++r) {
+        size_t first = (block * ALLELE_PARITY_BLOCK_ROWS + r) * ALLELE_PARITY_ROW_BITS;
+        for (c = 0; c < ALLELE_PARITY_ROW_BITS; ++c) {
+            size_t i = first + c;
+            storage[r][c] = (i < bit_count && get_bit(payload, i)) ? DNA_BASE_T : DNA_BASE_A;
+        }
+        storage[r][ALLELE_PARITY_ROW_BITS] = '\0';
+        rows[r] = storage[r];
+    }
+
+    parity = build_parity_block(rows, data_rows, &total_rows, &total_cols);
+    if (!parity) {
+        return "Failed to build parity block for embedded alleles.";
+    }
+
+    for (r = 0; r < data_rows; ++r, ++digit) {
+        int value = parity_digit(parity[r][ALLELE_PARITY_ROW_BITS]);
+        put_bit(encoded, parity_start + digit * 2, (value >> 1) & 1);
+        put_bit(encoded, parity_start + digit * 2 + 1, value & 1);
+    }
+    for (c = 0; c <= ALLELE_PARITY_ROW_BITS; ++c, ++digit) {
+        int value = parity_digit(parity[data_rows][c]);
+        put_bit(encoded, parity_start + digit * 2, (value >> 1) & 1);
+        put_bit(encoded, parity_start + digit * 2 + 1, value & 1);
+    }
+
+    free_parity_block(parity, total_rows);
+    return NULL;
+}
+
+/*
+ * Rebuilds one parity block from the extracted stream, runs the detector and
+ * writes any corrected payload bit back into `encoded`.
+ */
+static const char *decode_block(uint8_t *encoded,
+                                size_t payload_len,
+                                size_t block,
+                                size_t digit_offset,
+                                int *out_corrected) {
+    char storage[ALLELE_PARITY_BLOCK_ROWS + 1][ALLELE_PARITY_ROW_BITS + 2];
+    char *rows[ALLELE_PARITY_BLOCK_ROWS + 1];
+    size_t data_rows = rows_in_block(payload_len, block);
+    size_t bit_count = payload_len * 8;
+    size_t parity_start = bit_count;
+    size_t first_bit = block * ALLELE_PARITY_BLOCK_ROWS * ALLELE_PARITY_ROW_BITS;
+    size_t digit = digit_offset;
+    size_t corrected_row = 0;
+    size_t corrected_col = 0;
+    int status;
+    size_t r;
+    size_t c;
+
+    /* Padding bits past the payload are implicitly 0 on both sides. */
+    for (r = 0; r < data_rows; ++r) {
+        for (c = 0; c < ALLELE_PARITY_ROW_BITS; ++c) {
+            size_t i = first_bit + r * ALLELE_PARITY_ROW_BITS + c;
+            storage[r][c] = (i < bit_count && get_bit(encoded, i)) ? DNA_BASE_T : DNA_BASE_A;
+        }
+        rows[r] = storage[r];
+    }
+    for (r = 0; r < data_rows; ++r, ++digit) {
+        int value = (get_bit(encoded, parity_start + digit * 2) << 1) |
+                    get_bit(encoded, parity_start + digit * 2 + 1);
+        storage[r][ALLELE_PARITY_ROW_BITS] = parity_base(value);
+    }
+    for (c = 0; c <= ALLELE_PARITY_ROW_BITS; ++c, ++digit) {
+        int value = (get_bit(encoded, parity_start + digit * 2) << 1) |
+                    get_bit(encoded, parity_start + digit * 2 + 1);
+        storage[data_rows][c] = parity_base(value);
+    }
+    rows[data_rows] = storage[data_rows];
+
+    *out_corrected = 0;
+    status = detect_and_correct_parity_block(rows, data_rows + 1, ALLELE_PARITY_ROW_BITS + 1,
+                                             &corrected_row, &corrected_col);
+    if (status == PARITY_OK) {
+        return NULL;
+    }
+    if (status != PARITY_CORRECTED) {
+        return "Parity check failed: embedded payload is damaged beyond repair.";
+    }
+
+    *out_corrected = 1;
+    if (corrected_row < data_rows && corrected_col < ALLELE_PARITY_ROW_BITS) {
+        size_t i = first_bit + corrected_row * ALLELE_PARITY_ROW_BITS + corrected_col;
+        int value = parity_digit(rows[corrected_row][corrected_col]);
+
+        /* Payload cells only ever hold A or T; anything else is not a single flip. */
+        if (value > 1 || (i >= bit_count && value != 0)) {
+            return "Parity check failed: embedded payload is damaged beyond repair.";
+        }
+        if (i < bit_count) {
+            put_bit(encoded, i, value);
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,69 @@
+/*
+ * Block sum parity applied to the embedded allele stream rather than to whole
+ * sequences. Only payload bits are protected, so redundancy and checking work
+ * scale with the payload instead of the genome.
+ */
+
+#ifndef ALLELE_PARITY_H
+#define ALLELE_PARITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "embedding.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Payload bits are laid out as rows of ALLELE_PARITY_ROW_BITS bits and grouped
+ * into blocks of up to ALLELE_PARITY_BLOCK_ROWS rows. Each block is protected
+ * by the row/column parity codec from the error detection module and can
+ * repair one flipped or unreadable allele.
+ */
+#define ALLELE_PARITY_ROW_BITS 16
+#define ALLELE_PARITY_BLOCK_ROWS 16
+
+/*
+ * Number of bytes actually embedded for a `payload_len` byte payload: the
+ * payload itself followed by the packed parity symbols, which occupy the
+ * candidates reserved after the payload bits.
+ */
+size_t allele_parity_encoded_length(size_t payload_len);
+
+/*
+ * Embeds `payload` followed by its parity symbols. Arguments match
+ * `embed_bitstream_permuted`; the candidate list must provide
+ * `allele_parity_encoded_length(payload_len) * 8` positions.
+ */
+int embed_bitstream_protected(const char *sequence,
+                              const CandidateSNP *candidates,
+                              size_t num_candidates,
+                              const uint8_t *payload,
+                              size_t payload_len,
+                              const CandidatePermutation *permutation,
+                              int num_threads,
+                              EmbeddingResult *out_result,
+                              char **out_error);
+
+/*
+ * Extracts a payload written by `embed_bitstream_protected` and runs the
+ * parity decoder over it immediately. Single-allele corruption in a block is
+ * corrected; `out_corrected` (optional) receives the number of repaired
+ * blocks. Returns -1 when a block is damaged beyond repair.
+ */
+int extract_bitstream_protected(const char *sequence,
+                                const CandidateSNP *candidates,
+                                size_t num_candidates,
+                                const CandidatePermutation *permutation,
+                                uint8_t *out_payload,
+                                size_t payload_len,
+                                size_t *out_corrected,
+                                char **out_error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALLELE_PARITY_H */
@@ -6,9 +6,297 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "allele_parity.h"
 #include "embedding.h"
 
+/* 4096 payload bits, the smallest payload that takes the parallel branch. */
+#define LARGE_PAYLOAD_BYTES 512
+#define LARGE_SEQUENCE_BASES 8192
+
+/*
+ * Embeds a payload large enough to run on several threads and compares it with
+ * the serial result, then checks that a repeated candidate position fails the
+ * same way in both variants.
+ */
+static int demo_parallel_embedding(void) {
+    static char sequence[LARGE_SEQUENCE_BASES + 1];
+    static CandidateSNP candidates[LARGE_SEQUENCE_BASES];
+    uint8_t payload[LARGE_PAYLOAD_BYTES];
+    EmbeddingResult serial;
+    EmbeddingResult parallel;
+    char *serial_error = NULL;
+    char *parallel_error = NULL;
+    int matches;
+    int rejected;
+    int serial_status;
+    int parallel_status;
+    size_t i;
+
+    for (i = 0; i < LARGE_SEQUENCE_BASES; ++i) {
+        sequence[i] = "ACGT"[(i * 7 + i / 5) % 4];
+        candidates[i].position = i;
+        candidates[i].reference = sequence[i];
+        candidates[i].alternates = NULL;
+        candidates[i].num_alternates = 0;
+    }
+    sequence[LARGE_SEQUENCE_BASES] = '\0';
+    for (i = 0; i < LARGE_PAYLOAD_BYTES; ++i) {
+        payload[i] = (uint8_t)(i * 37 + 11);
+    }
+
+    if (embed_bitstream(sequence, candidates, LARGE_SEQUENCE_BASES, payload, sizeof(payload),
+                        &serial, &serial_error) != 0 ||
+        embed_bitstream_parallel(sequence, candidates, LARGE_SEQUENCE_BASES, payload, sizeof(payload),
+                                 4, &parallel, &parallel_error) != 0) {
+        fprintf(stderr, "Parallel embedding failed: %s\n",
+                serial_error ? serial_error : parallel_error ? parallel_error : "unknown error");
+        free(serial_error);
+        free(parallel_error);
+        return -1;
+    }
+    matches = strcmp(serial.sequence, parallel.sequence) == 0 &&
+              memcmp(serial.alleles, parallel.alleles, serial.num_alleles * sizeof(EmbeddedAllele)) == 0;
+    printf("Parallel embedding matches serial (%d bits): %s\n", LARGE_PAYLOAD_BYTES * 8, matches ? "yes" : "no");
+    free_embedding_result(&serial);
+    free_embedding_result(&parallel);
+
+    /* Bit 5 lands on the base bit 3 already replaced. */
+    candidates[5].position = 3;
+    candidates[5].reference = sequence[3];
+    serial_status = embed_bitstream(sequence, candidates, LARGE_SEQUENCE_BASES, payload, sizeof(payload),
+                                    &serial, &serial_error);
+    parallel_status = embed_bitstream_parallel(sequence, candidates, LARGE_SEQUENCE_BASES, payload,
+                                               sizeof(payload), 4, &parallel, &parallel_error);
+    rejected = serial_status != 0 && parallel_status != 0 && serial_error && parallel_error &&
+               strcmp(serial_error, parallel_error) == 0;
+    printf("Repeated position rejected like serial: %s\n", rejected ? "yes" : "no");
+    free(serial_error);
+    free(parallel_error);
+    return matches && rejected ? 0 : -1;
+}
+
+#define SHARED_SEQUENCE_BASES 32
+#define SHARED_JOB_CANDIDATES 16
+
+/*
+ * Runs two embedding jobs on one SharedSequence, one per thread when OpenMP is
+ * available. Job 0 uses positions 0-15 and job 1 positions 8-23 (or 0-15 with
+ * EMBED_CONFLICT_SKIP), so the jobs always compete for some bases.
+ */
+static void run_shared_jobs(SharedSequence *shared,
+                            const CandidateSNP candidates[2][SHARED_JOB_CANDIDATES],
+                            const uint8_t payloads[2][2],
+                            size_t payload_len,
+                            EmbedConflictPolicy policy,
+                            EmbeddingResult results[2],
+                            int statuses[2],
+                            size_t conflicts[2],
+                            char *errors[2]) {
+    int job;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(2) schedule(static, 1)
+#endif
+    for (job = 0; job < 2; ++job) {
+        errors[job] = NULL;
+        results[job].sequence = NULL;
+        results[job].alleles = NULL;
+        results[job].num_alleles = 0;
+        statuses[job] = embed_bitstream_shared(shared, candidates[job], SHARED_JOB_CANDIDATES,
+                                               payloads[job], payload_len, policy, &results[job],
+                                               &conflicts[job], &errors[job]);
+    }
+}
+
+/* Returns 1 when every recorded allele is present in the shared sequence. */
+static int alleles_present(const SharedSequence *shared, const EmbeddingResult *result) {
+    const char *data = shared_sequence_data(shared);
+    size_t i;
+    for (i = 0; i < result->num_alleles; ++i) {
+        if (data[result->alleles[i].position] != result->alleles[i].allele) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int demo_shared_sequence(void) {
+    char sequence[SHARED_SEQUENCE_BASES + 1];
+    CandidateSNP candidates[2][SHARED_JOB_CANDIDATES];
+    const uint8_t payloads[2][2] = {{0x5A, 0xC3}, {0x0F, 0x96}};
+    EmbeddingResult results[2];
+    int statuses[2];
+    size_t conflicts[2];
+    char *errors[2];
+    SharedSequence *shared;
+    char *error = NULL;
+    int fail_ok;
+    int skip_ok;
+    int job;
+    size_t i;
+
+    for (i = 0; i < SHARED_SEQUENCE_BASES; ++i) {
+        sequence[i] = "ACGT"[i % 4];
+    }
+    sequence[SHARED_SEQUENCE_BASES] = '\0';
+    for (job = 0; job < 2; ++job) {
+        for (i = 0; i < SHARED_JOB_CANDIDATES; ++i) {
+            size_t pos = i + (size_t)job * 8;
+            candidates[job][i].position = pos;
+            candidates[job][i].reference = sequence[pos];
+            candidates[job][i].alternates = NULL;
+            candidates[job][i].num_alternates = 0;
+        }
+    }
+
+    /*
+     * EMBED_CONFLICT_FAIL: both jobs need every one of their candidates, so at
+     * least one hits a base claimed by the other. A failed job must report the
+     * conflict and leave no trace in the shared sequence.
+     */
+    shared = shared_sequence_create(sequence, &error);
+    if (!shared) {
+        fprintf(stderr, "Shared sequence failed: %s\n", error ? error : "unknown error");
+        free(error);
+        return -1;
+    }
+    run_shared_jobs(shared, (const CandidateSNP(*)[SHARED_JOB_CANDIDATES])candidates, payloads, 2,
+                    EMBED_CONFLICT_FAIL, results, statuses, conflicts, errors);
+    fail_ok = statuses[0] != 0 || statuses[1] != 0;
+    for (i = 0; i < SHARED_SEQUENCE_BASES; ++i) {
+        char expected = sequence[i];
+        for (job = 0; job < 2; ++job) {
+            size_t k;
+            for (k = 0; statuses[job] == 0 && k < results[job].num_alleles; ++k) {
+                if (results[job].alleles[k].position == i) {
+                    expected = results[job].alleles[k].allele;
+                }
+            }
+        }
+        fail_ok &= shared_sequence_data(shared)[i] == expected;
+    }
+    for (job = 0; job < 2; ++job) {
+        if (statuses[job] != 0) {
+            fail_ok &= conflicts[job] > 0 && errors[job] && strstr(errors[job], "already claimed") != NULL;
+        }
+        free(errors[job]);
+        free_embedding_result(&results[job]);
+    }
+    shared_sequence_destroy(shared);
+    printf("Shared sequence conflict fails and rolls back: %s\n", fail_ok ? "yes" : "no");
+
+    /*
+     * EMBED_CONFLICT_SKIP: both jobs draw 8 bits from the same 16 candidates.
+     * Whichever loses the race for a base moves on, so both succeed, the
+     * skipped bases are counted and the alleles land on disjoint positions.
+     */
+    for (i = 0; i < SHARED_JOB_CANDIDATES; ++i) {
+        candidates[1][i] = candidates[0][i];
+    }
+    shared = shared_sequence_create(sequence, &error);
+    if (!shared) {
+        fprintf(stderr, "Shared sequence failed: %s\n", error ? error : "unknown error");
+        free(error);
+        return -1;
+    }
+    run_shared_jobs(shared, (const CandidateSNP(*)[SHARED_JOB_CANDIDATES])candidates, payloads, 1,
+                    EMBED_CONFLICT_SKIP, results, statuses, conflicts, errors);
+    skip_ok = statuses[0] == 0 && statuses[1] == 0 && conflicts[0] + conflicts[1] > 0;
+    if (skip_ok) {
+        skip_ok = alleles_present(shared, &results[0]) && alleles_present(shared, &results[1]);
+        for (i = 0; skip_ok && i < results[0].num_alleles; ++i) {
+            size_t k;
+            for (k = 0; k < results[1].num_alleles; ++k) {
+                skip_ok &= results[0].alleles[i].position != results[1].alleles[k].position;
+            }
+        }
+    }
+    for (job = 0; job < 2; ++job) {
+        free(errors[job]);
+        free_embedding_result(&results[job]);
+    }
+    shared_sequence_destroy(shared);
+    printf("Shared sequence skips claimed bases (%zu conflicts): %s\n", conflicts[0] + conflicts[1],
+           skip_ok ? "yes" : "no");
+    return fail_ok && skip_ok ? 0 : -1;
+}
+
+/* Two parity blocks of ALLELE_PARITY_BLOCK_ROWS x ALLELE_PARITY_ROW_BITS bits. */
+#define PROTECTED_PAYLOAD_BYTES 64
+
+/* Replaces the allele carrying encoded bit `index` with the allele for the opposite bit. */
+static int flip_allele(char *sequence, const EmbeddingResult *result, size_t index) {
+    const EmbeddedAllele *target = &result->alleles[index];
+    size_t i;
+    for (i = 0; i < result->num_alleles; ++i) {
+        if (result->alleles[i].reference == target->reference && result->alleles[i].bit != target->bit) {
+            sequence[target->position] = result->alleles[i].allele;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Embeds a parity-protected payload, flips one payload allele in the first
+ * block and one parity allele of the second block, and checks that extraction
+ * repairs both blocks.
+ */
+static int demo_protected_embedding(void) {
+    static char sequence[LARGE_SEQUENCE_BASES + 1];
+    static CandidateSNP candidates[LARGE_SEQUENCE_BASES];
+    uint8_t payload[PROTECTED_PAYLOAD_BYTES];
+    uint8_t recovered[PROTECTED_PAYLOAD_BYTES];
+    const size_t block_parity_bits = (ALLELE_PARITY_BLOCK_ROWS + ALLELE_PARITY_ROW_BITS + 1) * 2;
+    size_t num_candidates = allele_parity_encoded_length(PROTECTED_PAYLOAD_BYTES) * 8;
+    EmbeddingResult result;
+    char *error = NULL;
+    size_t corrected = 0;
+    int restored;
+    size_t i;
+
+    for (i = 0; i < num_candidates; ++i) {
+        sequence[i] = "ACGT"[(i * 5 + i / 3) % 4];
+        candidates[i].position = i;
+        candidates[i].reference = sequence[i];
+        candidates[i].alternates = NULL;
+        candidates[i].num_alternates = 0;
+    }
+    sequence[num_candidates] = '\0';
+    for (i = 0; i < PROTECTED_PAYLOAD_BYTES; ++i) {
+        payload[i] = (uint8_t)(i * 29 + 3);
+    }
+
+    if (embed_bitstream_protected(sequence, candidates, num_candidates, payload, PROTECTED_PAYLOAD_BYTES,
+                                  NULL, 0, &result, &error) != 0) {
+        fprintf(stderr, "Protected embedding failed: %s\n", error ? error : "unknown error");
+        free(error);
+        return -1;
+    }
+
+    /* Without a permutation, allele i carries encoded bit i. */
+    if (flip_allele(result.sequence, &result, 5) != 0 ||
+        flip_allele(result.sequence, &result, PROTECTED_PAYLOAD_BYTES * 8 + block_parity_bits + 1) != 0) {
+        fprintf(stderr, "Protected embedding: no opposite allele to flip.\n");
+        free_embedding_result(&result);
+        return -1;
+    }
+
+    if (extract_bitstream_protected(result.sequence, candidates, num_candidates, NULL, recovered,
+                                    PROTECTED_PAYLOAD_BYTES, &corrected, &error) != 0) {
+        fprintf(stderr, "Protected extraction failed: %s\n", error ? error : "unknown error");
+        free(error);
+        free_embedding_result(&result);
+        return -1;
+    }
+    free_embedding_result(&result);
+
+    restored = memcmp(recovered, payload, sizeof(payload)) == 0 && corrected == 2;
+    printf("Protected payload restored (%zu blocks corrected): %s\n", corrected, restored ? "yes" : "no");
+    return restored ? 0 : -1;
+}
+
 int main(void) {
     const char *sequence = "ACGTACGTACGT";
     CandidateSNP candidates[] = {
@@ -23,6 +311,16 @@ int main(void) {
     };
     const uint8_t payload[] = {0xB6};
     EmbeddingResult result;
+    EmbeddingResult permuted_result;
+    EmbeddingResult plan_result;
+    EmbeddingPlan *plan;
+    int plan_matches;
+    const uint8_t key[CANDIDATE_PERMUTATION_KEY_BYTES] = {
+        0x3A, 0x91, 0x5C, 0x07, 0xE2, 0x4B, 0xD8, 0x66,
+        0x1F, 0xA4, 0x72, 0xC9, 0x0E, 0xB5, 0x38, 0x5D
+    };
+    CandidatePermutation permutation;
+    uint8_t recovered[sizeof(payload)];
     char *error = NULL;
     size_t i;
 
@@ -50,7 +348,66 @@ int main(void) {
                allele->bit);
     }
 
+    if (demo_parallel_embedding() != 0 || demo_shared_sequence() != 0 || demo_protected_embedding() != 0) {
+        free_embedding_result(&result);
+        return EXIT_FAILURE;
+    }
+
+    candidate_permutation_init(&permutation, sizeof(candidates) / sizeof(candidates[0]), key);
+    if (embed_bitstream_permuted(sequence,
+                                 candidates,
+                                 sizeof(candidates) / sizeof(candidates[0]),
+                                 payload,
+                                 sizeof(payload),
+                                 &permutation,
+                                 0,
+                                 &permuted_result,
+                                 &error) != 0 ||
+        extract_bitstream(permuted_result.sequence,
+                          candidates,
+                          sizeof(candidates) / sizeof(candidates[0]),
+                          &permutation,
+                          recovered,
+                          sizeof(recovered),
+                          &error) != 0) {
+        fprintf(stderr, "Keyed embedding failed: %s\n", error ? error : "unknown error");
+        free(error);
+        free_embedding_result(&result);
+        return EXIT_FAILURE;
+    }
+    printf("Keyed embedded sequence: %s\n", permuted_result.sequence);
+    printf("Recovered payload: 0x%02X\n", recovered[0]);
+    if (memcmp(recovered, payload, sizeof(payload)) != 0) {
+        fprintf(stderr, "Keyed round trip did not recover the payload.\n");
+        free_embedding_result(&permuted_result);
+        free_embedding_result(&result);
+        return EXIT_FAILURE;
+    }
+
+    plan = embedding_plan_compile(sequence, candidates, sizeof(candidates) / sizeof(candidates[0]), &error);
+    if (!plan || embedding_plan_apply(plan,
+                                      payload,
+                                      sizeof(payload),
+                                      &permutation,
+                                      0,
+                                      &plan_result,
+                                      &error) != 0) {
+        fprintf(stderr, "Planned embedding failed: %s\n", error ? error : "unknown error");
+        free(error);
+        embedding_plan_free(plan);
+        free_embedding_result(&permuted_result);
+        free_embedding_result(&result);
+        return EXIT_FAILURE;
+    }
+    plan_matches = strcmp(plan_result.sequence, permuted_result.sequence) == 0 &&
+                   memcmp(plan_result.alleles, permuted_result.alleles,
+                          permuted_result.num_alleles * sizeof(EmbeddedAllele)) == 0;
+    printf("Planned embedding matches keyed: %s\n", plan_matches ? "yes" : "no");
+
+    free_embedding_result(&plan_result);
+    embedding_plan_free(plan);
+    free_embedding_result(&permuted_result);
     free_embedding_result(&result);
-    return EXIT_SUCCESS;
+    return plan_matches ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -8,6 +8,7 @@
 */ 
 
 #include <ctype.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -16,6 +17,10 @@
 
 #include "embedding.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /*
  * SNP embedding utilities for hiding encrypted payloads within genomic
  * sequences. This module mirrors the behavior of the previous Python
@@ -27,11 +32,61 @@
 
 static int set_error(char **out_error, const char *message);
 static int base_index(char base);
-static int select_allele(char reference,
-                         int bit,
-                         const CandidateSNP *candidate,
-                         char *out_allele,
-                         char **out_error);
+static const char *select_allele(char reference,
+                                 int bit,
+                                 const CandidateSNP *candidate,
+                                 char *out_allele);
+static int prepare_embedding(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             const EmbeddingResult *out_result,
+                             size_t *out_seq_len,
+                             char **out_mutated,
+                             EmbeddedAllele **out_alleles,
+                             char **out_error);
+static const char *embed_bit(const char *lookup,
+                             size_t seq_len,
+                             const CandidateSNP *candidate,
+                             int bit,
+                             EmbeddedAllele *out_allele);
+
+struct SharedSequence {
+    char *sequence;             /* Mutable sequence shared by all jobs. */
+    size_t length;              /* Length of `sequence` in bases. */
+    _Atomic uint64_t *claimed;  /* One bit per position, set once claimed. */
+};
+
+struct EmbeddingPlan {
+    char *sequence;     /* Private copy of the validated sequence. */
+    size_t length;      /* Length of `sequence` in bases. */
+    size_t count;       /* Number of compiled candidates. */
+    size_t *positions;  /* Validated position of each candidate. */
+    uint8_t *codes;     /* Reference, bit-0 and bit-1 alleles, 2 bits each. */
+};
+
+static const char *extract_bit(const char *sequence,
+                               size_t seq_len,
+                               const CandidateSNP *candidate,
+                               int *out_bit);
+static int extract_payload(const char *sequence,
+                           const CandidateSNP *candidates,
+                           size_t num_candidates,
+                           const CandidatePermutation *permutation,
+                           uint8_t *out_payload,
+                           size_t payload_len,
+                           int tolerant,
+                           size_t *out_unreadable,
+                           char **out_error);
+static uint64_t mix64(uint64_t value);
+static int claim_position(SharedSequence *shared, size_t pos);
+static int mark_position(_Atomic uint64_t *bitmap, size_t pos);
+static void release_position(SharedSequence *shared, size_t pos);
+
+/* Returned by extract_bit when a base matches neither payload allele. */
+static const char UNREADABLE_ALLELE_MESSAGE[] =
+    "Sequence base at candidate position does not encode a payload bit.";
 
 /* Deterministic mapping used when alternates are not provided. */
 static const char DEFAULT_ALLELE_MAP[4][2] = {
@@ -59,11 +114,326 @@ int embed_bitstream(const char *sequence,
     EmbeddedAllele *alleles;
     size_t i;
 
+    if (prepare_embedding(sequence, candidates, num_candidates, payload, payload_len,
+                          out_result, &seq_len, &mutated, &alleles, out_error) != 0) {
+        return -1;
+    }
+    bit_count = payload_len * 8;
+
+    for (i = 0; i < bit_count; ++i) {
+        size_t byte_index = i / 8;
+        size_t bit_offset = 7 - (i % 8);
+        int bit = (payload[byte_index] >> bit_offset) & 1;
+        const char *message = embed_bit(mutated, seq_len, &candidates[i], bit, &alleles[i]);
+
+        if (message) {
+            set_error(out_error, message);
+            free(mutated);
+            free(alleles);
+            return -1;
+        }
+        mutated[alleles[i].position] = alleles[i].allele;
+    }
+
+    out_result->sequence = mutated;
+    out_result->alleles = alleles;
+    out_result->num_alleles = bit_count;
+    return 0;
+}
+
+int embed_bitstream_parallel(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             int num_threads,
+                             EmbeddingResult *out_result,
+                             char **out_error) {
+    return embed_bitstream_permuted(sequence, candidates, num_candidates, payload, payload_len,
+                                    NULL, num_threads, out_result, out_error);
+}
+
+int embed_bitstream_permuted(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             const CandidatePermutation *permutation,
+                             int num_threads,
+                             EmbeddingResult *out_result,
+                             char **out_error) {
+    size_t seq_len;
+    size_t bit_count;
+    char *mutated;
+    EmbeddedAllele *alleles;
+    _Atomic uint64_t *written;
+    size_t words;
+    size_t error_index;
+    const char *error_message = NULL;
+    int duplicate = 0;
+    long index;
+
+    if (prepare_embedding(sequence, candidates, num_candidates, payload, payload_len,
+                          out_result, &seq_len, &mutated, &alleles, out_error) != 0) {
+        return -1;
+    }
+    bit_count = payload_len * 8;
+
+    if (permutation && permutation->domain != num_candidates) {
+        free(mutated);
+        free(alleles);
+        return set_error(out_error, "Candidate permutation does not match candidate count.");
+    }
+
+    /* One bit per position, so two bits landing on the same base are detected. */
+    words = seq_len / 64 + 1;
+    written = (_Atomic uint64_t *)malloc(words * sizeof(_Atomic uint64_t));
+    if (!written) {
+        free(mutated);
+        free(alleles);
+        return set_error(out_error, "Failed to allocate memory for sequence.");
+    }
+    for (index = 0; index < (long)words; ++index) {
+        atomic_init(&written[index], 0);
+    }
+
+#ifdef _OPENMP
+    if (num_threads <= 0) {
+        num_threads = omp_get_max_threads();
+    }
+#else
+    (void)num_threads;
+#endif
+
+    /*
+     * Each thread owns a contiguous block of payload bits and therefore a
+     * disjoint slice of `alleles`. Reference checks read the unmodified input
+     * sequence so the outcome does not depend on thread interleaving. When
+     * several bits fail, the lowest failing index wins, which matches the error
+     * the serial variant would have reported.
+     */
+    error_index = bit_count;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) \
+    if (bit_count >= EMBED_PARALLEL_MIN_BITS)
+#endif
+    for (index = 0; index < (long)bit_count; ++index) {
+        size_t i = (size_t)index;
+        size_t slot = permutation ? candidate_permutation_apply(permutation, i) : i;
+        int bit = (payload[i / 8] >> (7 - (i % 8))) & 1;
+        const char *message = embed_bit(sequence, seq_len, &candidates[slot], bit, &alleles[i]);
+
+        if (message) {
+#ifdef _OPENMP
+#pragma omp critical(embed_bitstream_error)
+#endif
+            {
+                if (i < error_index) {
+                    error_index = i;
+                    error_message = message;
+                }
+            }
+            continue;
+        }
+        if (mark_position(written, alleles[i].position)) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+            duplicate = 1;
+            continue;
+        }
+        mutated[alleles[i].position] = alleles[i].allele;
+    }
+
+    /*
+     * Which of two bits sharing a position claimed it first depends on thread
+     * timing, so rescan serially for the lowest bit whose position an earlier
+     * bit already used. The serial variant fails there with a reference
+     * mismatch, because the earlier bit has already replaced the base.
+     */
+    if (duplicate) {
+        size_t i;
+        for (i = 0; i < words; ++i) {
+            atomic_store_explicit(&written[i], 0, memory_order_relaxed);
+        }
+        for (i = 0; i < error_index; ++i) {
+            size_t slot = permutation ? candidate_permutation_apply(permutation, i) : i;
+            size_t pos = candidates[slot].position;
+            if (pos < seq_len && mark_position(written, pos)) {
+                error_index = i;
+                error_message = "Reference base does not match sequence at candidate position.";
+                break;
+            }
+        }
+    }
+    free((void *)written);
+
+    if (error_message) {
+        set_error(out_error, error_message);
+        free(mutated);
+        free(alleles);
+        return -1;
+    }
+
+    out_result->sequence = mutated;
+    out_result->alleles = alleles;
+    out_result->num_alleles = bit_count;
+    return 0;
+}
+
+int extract_bitstream(const char *sequence,
+                      const CandidateSNP *candidates,
+                      size_t num_candidates,
+                      const CandidatePermutation *permutation,
+                      uint8_t *out_payload,
+                      size_t payload_len,
+                      char **out_error) {
+    return extract_payload(sequence, candidates, num_candidates, permutation,
+                           out_payload, payload_len, 0, NULL, out_error);
+}
+
+int extract_bitstream_tolerant(const char *sequence,
+                               const CandidateSNP *candidates,
+                               size_t num_candidates,
+                               const CandidatePermutation *permutation,
+                               uint8_t *out_payload,
+                               size_t payload_len,
+                               size_t *out_unreadable,
+                               char **out_error) {
+    return extract_payload(sequence, candidates, num_candidates, permutation,
+                           out_payload, payload_len, 1, out_unreadable, out_error);
+}
+
+int candidate_permutation_init(CandidatePermutation *perm,
+                               size_t num_candidates,
+                               const uint8_t *key) {
+    uint64_t k0 = 0;
+    uint64_t k1 = 0;
+    unsigned half_bits = 1;
+    size_t i;
+
+    if (!perm || !key) {
+        return -1;
+    }
+
+    for (i = 0; i < 8; ++i) {
+        k0 = (k0 << 8) | key[i];
+        k1 = (k1 << 8) | key[i + 8];
+    }
+
+    /* Smallest even bit width whose range covers the domain. */
+    while (half_bits < 32 && ((uint64_t)1 << (2 * half_bits)) < (uint64_t)num_candidates) {
+        half_bits++;
+    }
+
+    perm->domain = (uint64_t)num_candidates;
+    perm->half_bits = half_bits;
+    for (i = 0; i < CANDIDATE_PERMUTATION_ROUNDS; ++i) {
+        perm->round_keys[i] = mix64(k0 + 0x9E3779B97F4A7C15ULL * (i + 1)) ^ k1;
+    }
+    return 0;
+}
+
+size_t candidate_permutation_apply(const CandidatePermutation *perm, size_t index) {
+    uint64_t half_mask = ((uint64_t)1 << perm->half_bits) - 1;
+    uint64_t value = (uint64_t)index;
+
+    /*
+     * Balanced Feistel network over 2 * half_bits bits. Values that land
+     * outside the domain are re-encrypted (cycle walking); because the range
+     * is less than four times the domain this takes few iterations on average.
+     */
+    do {
+        uint64_t left = value >> perm->half_bits;
+        uint64_t right = value & half_mask;
+        size_t round;
+
+        for (round = 0; round < CANDIDATE_PERMUTATION_ROUNDS; ++round) {
+            uint64_t next = left ^ (mix64(right ^ perm->round_keys[round]) & half_mask);
+            left = right;
+            right = next;
+        }
+        value = (left << perm->half_bits) | right;
+    } while (value >= perm->domain);
+
+    return (size_t)value;
+}
+
+SharedSequence *shared_sequence_create(const char *sequence, char **out_error) {
+    SharedSequence *shared;
+    size_t words;
+    size_t i;
+
     if (out_error) {
         *out_error = NULL;
     }
 
-    if (!sequence || !candidates || !out_result) {
+    if (!sequence) {
+        set_error(out_error, "Invalid argument: NULL pointer supplied.");
+        return NULL;
+    }
+
+    shared = (SharedSequence *)calloc(1, sizeof(SharedSequence));
+    if (!shared) {
+        set_error(out_error, "Failed to allocate memory for shared sequence.");
+        return NULL;
+    }
+
+    shared->length = strlen(sequence);
+    words = shared->length / 64 + 1;
+    shared->sequence = (char *)malloc(shared->length + 1);
+    shared->claimed = (_Atomic uint64_t *)malloc(words * sizeof(_Atomic uint64_t));
+    if (!shared->sequence || !shared->claimed) {
+        shared_sequence_destroy(shared);
+        set_error(out_error, "Failed to allocate memory for shared sequence.");
+        return NULL;
+    }
+    memcpy(shared->sequence, sequence, shared->length + 1);
+    for (i = 0; i < words; ++i) {
+        atomic_init(&shared->claimed[i], 0);
+    }
+    return shared;
+}
+
+const char *shared_sequence_data(const SharedSequence *shared) {
+    return shared ? shared->sequence : NULL;
+}
+
+void shared_sequence_destroy(SharedSequence *shared) {
+    if (!shared) {
+        return;
+    }
+    free(shared->sequence);
+    free((void *)shared->claimed);
+    free(shared);
+}
+
+int embed_bitstream_shared(SharedSequence *shared,
+                           const CandidateSNP *candidates,
+                           size_t num_candidates,
+                           const uint8_t *payload,
+                           size_t payload_len,
+                           EmbedConflictPolicy policy,
+                           EmbeddingResult *out_result,
+                           size_t *out_conflicts,
+                           char **out_error) {
+    size_t bit_count;
+    EmbeddedAllele *alleles;
+    char *originals;
+    size_t conflicts = 0;
+    size_t next = 0;
+    size_t embedded = 0;
+    const char *message = NULL;
+    size_t i;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+    if (out_conflicts) {
+        *out_conflicts = 0;
+    }
+
+    if (!shared || !candidates || !out_result) {
         return set_error(out_error, "Invalid argument: NULL pointer supplied.");
     }
 
@@ -71,67 +441,236 @@ int embed_bitstream(const char *sequence,
         return set_error(out_error, "Invalid argument: payload data is NULL.");
     }
 
-    seq_len = strlen(sequence);
     bit_count = payload_len * 8;
-
     if (bit_count > num_candidates) {
         return set_error(out_error,
                          "Insufficient candidate SNPs for payload capacity.");
     }
 
-    mutated = (char *)malloc(seq_len + 1);
+    if (bit_count == 0) {
+        out_result->sequence = NULL;
+        out_result->alleles = NULL;
+        out_result->num_alleles = 0;
+        return 0;
+    }
+
+    alleles = (EmbeddedAllele *)calloc(bit_count, sizeof(EmbeddedAllele));
+    originals = (char *)malloc(bit_count);
+    if (!alleles || !originals) {
+        free(alleles);
+        free(originals);
+        return set_error(out_error, "Failed to allocate memory for alleles.");
+    }
+
+    for (i = 0; i < bit_count && !message; ++i) {
+        int bit = (payload[i / 8] >> (7 - (i % 8))) & 1;
+
+        for (;;) {
+            const CandidateSNP *candidate;
+            size_t pos;
+
+            if (next >= num_candidates) {
+                message = "Insufficient unclaimed candidate SNPs for payload capacity.";
+                break;
+            }
+            candidate = &candidates[next++];
+            pos = candidate->position;
+            if (pos >= shared->length) {
+                message = "Candidate SNP position outside sequence bounds.";
+                break;
+            }
+            if (!claim_position(shared, pos)) {
+                conflicts++;
+                if (policy == EMBED_CONFLICT_FAIL) {
+                    message = "Candidate SNP position already claimed by another payload.";
+                    break;
+                }
+                continue;
+            }
+            /* The claim gives this job exclusive access to `pos`. */
+            message = embed_bit(shared->sequence, shared->length, candidate, bit, &alleles[i]);
+            if (message) {
+                release_position(shared, pos);
+                break;
+            }
+            originals[i] = shared->sequence[pos];
+            shared->sequence[pos] = alleles[i].allele;
+            embedded++;
+            break;
+        }
+    }
+
+    if (out_conflicts) {
+        *out_conflicts = conflicts;
+    }
+
+    if (message) {
+        for (i = 0; i < embedded; ++i) {
+            shared->sequence[alleles[i].position] = originals[i];
+            release_position(shared, alleles[i].position);
+        }
+        free(alleles);
+        free(originals);
+        return set_error(out_error, message);
+    }
+
+    free(originals);
+    out_result->sequence = NULL;
+    out_result->alleles = alleles;
+    out_result->num_alleles = bit_count;
+    return 0;
+}
+
+/* Base order of the 2-bit codes stored in an EmbeddingPlan (see base_index). */
+static const char PLAN_BASES[4] = {'A', 'C', 'G', 'T'};
+
+EmbeddingPlan *embedding_plan_compile(const char *sequence,
+                                      const CandidateSNP *candidates,
+                                      size_t num_candidates,
+                                      char **out_error) {
+    EmbeddingPlan *plan;
+    uint64_t *seen;
+    const char *message = NULL;
+    size_t i;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+
+    if (!sequence || (!candidates && num_candidates > 0)) {
+        set_error(out_error, "Invalid argument: NULL pointer supplied.");
+        return NULL;
+    }
+
+    plan = (EmbeddingPlan *)calloc(1, sizeof(EmbeddingPlan));
+    if (!plan) {
+        set_error(out_error, "Failed to allocate memory for embedding plan.");
+        return NULL;
+    }
+    plan->length = strlen(sequence);
+    plan->count = num_candidates;
+    plan->sequence = (char *)malloc(plan->length + 1);
+    plan->positions = (size_t *)malloc((num_candidates + 1) * sizeof(size_t));
+    plan->codes = (uint8_t *)malloc(num_candidates + 1);
+    seen = (uint64_t *)calloc(plan->length / 64 + 1, sizeof(uint64_t));
+    if (!plan->sequence || !plan->positions || !plan->codes || !seen) {
+        free(seen);
+        embedding_plan_free(plan);
+        set_error(out_error, "Failed to allocate memory for embedding plan.");
+        return NULL;
+    }
+    memcpy(plan->sequence, sequence, plan->length + 1);
+
+    /* Resolve both alleles now so that applying a payload never re-validates. */
+    for (i = 0; i < num_candidates && !message; ++i) {
+        EmbeddedAllele zero;
+        EmbeddedAllele one;
+        size_t pos = candidates[i].position;
+
+        message = embed_bit(sequence, plan->length, &candidates[i], 0, &zero);
+        if (!message) {
+            message = embed_bit(sequence, plan->length, &candidates[i], 1, &one);
+        }
+        if (!message && (seen[pos / 64] >> (pos % 64)) & 1) {
+            message = "Candidate SNP positions must be distinct.";
+        }
+        if (message) {
+            break;
+        }
+        seen[pos / 64] |= (uint64_t)1 << (pos % 64);
+        plan->positions[i] = pos;
+        plan->codes[i] = (uint8_t)(base_index(zero.reference) |
+                                   (base_index(zero.allele) << 2) |
+                                   (base_index(one.allele) << 4));
+    }
+
+    free(seen);
+    if (message) {
+        embedding_plan_free(plan);
+        set_error(out_error, message);
+        return NULL;
+    }
+    return plan;
+}
+
+size_t embedding_plan_capacity(const EmbeddingPlan *plan) {
+    return plan ? plan->count : 0;
+}
+
+int embedding_plan_apply(const EmbeddingPlan *plan,
+                         const uint8_t *payload,
+                         size_t payload_len,
+                         const CandidatePermutation *permutation,
+                         int num_threads,
+                         EmbeddingResult *out_result,
+                         char **out_error) {
+    size_t bit_count;
+    char *mutated;
+    EmbeddedAllele *alleles;
+    long index;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+
+    if (!plan || !out_result) {
+        return set_error(out_error, "Invalid argument: NULL pointer supplied.");
+    }
+
+    if (payload_len > 0 && !payload) {
+        return set_error(out_error, "Invalid argument: payload data is NULL.");
+    }
+
+    /* Only sizes are checked; the candidates were validated at compile time. */
+    bit_count = payload_len * 8;
+    if (bit_count > plan->count) {
+        return set_error(out_error,
+                         "Insufficient candidate SNPs for payload capacity.");
+    }
+
+    if (permutation && permutation->domain != plan->count) {
+        return set_error(out_error, "Candidate permutation does not match candidate count.");
+    }
+
+    mutated = (char *)malloc(plan->length + 1);
     if (!mutated) {
         return set_error(out_error, "Failed to allocate memory for sequence.");
     }
-    memcpy(mutated, sequence, seq_len + 1);
+    memcpy(mutated, plan->sequence, plan->length + 1);
 
+    alleles = NULL;
     if (bit_count > 0) {
         alleles = (EmbeddedAllele *)calloc(bit_count, sizeof(EmbeddedAllele));
         if (!alleles) {
             free(mutated);
             return set_error(out_error, "Failed to allocate memory for alleles.");
         }
-    } else {
-        alleles = NULL;
     }
 
-    for (i = 0; i < bit_count; ++i) {
-        const CandidateSNP *candidate = &candidates[i];
-        size_t pos = candidate->position;
-        char expected = (char)toupper((unsigned char)candidate->reference);
-        char current;
-        char allele;
-        size_t byte_index = i / 8;
-        size_t bit_offset = 7 - (i % 8);
-        int bit = (payload[byte_index] >> bit_offset) & 1;
-
-        if (pos >= seq_len) {
-            set_error(out_error, "Candidate SNP position outside sequence bounds.");
-            free(mutated);
-            free(alleles);
-            return -1;
-        }
-
-        current = (char)toupper((unsigned char)mutated[pos]);
-        if (current != expected) {
-            set_error(out_error,
-                      "Reference base does not match sequence at candidate position.");
-            free(mutated);
-            free(alleles);
-            return -1;
-        }
+#ifdef _OPENMP
+    if (num_threads <= 0) {
+        num_threads = omp_get_max_threads();
+    }
+#else
+    (void)num_threads;
+#endif
 
-        if (select_allele(expected, bit, candidate, &allele, out_error) != 0) {
-            free(mutated);
-            free(alleles);
-            return -1;
-        }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(num_threads) \
+    if (bit_count >= EMBED_PARALLEL_MIN_BITS)
+#endif
+    for (index = 0; index < (long)bit_count; ++index) {
+        size_t i = (size_t)index;
+        size_t slot = permutation ? candidate_permutation_apply(permutation, i) : i;
+        int bit = (payload[i / 8] >> (7 - (i % 8))) & 1;
+        uint8_t code = plan->codes[slot];
+        char allele = PLAN_BASES[(code >> (2 + 2 * bit)) & 3];
 
-        mutated[pos] = allele;
-        alleles[i].position = pos;
-        alleles[i].reference = expected;
+        alleles[i].position = plan->positions[slot];
+        alleles[i].reference = PLAN_BASES[code & 3];
         alleles[i].allele = allele;
         alleles[i].bit = bit;
+        mutated[plan->positions[slot]] = allele;
     }
 
     out_result->sequence = mutated;
@@ -140,6 +679,16 @@ int embed_bitstream(const char *sequence,
     return 0;
 }
 
+void embedding_plan_free(EmbeddingPlan *plan) {
+    if (!plan) {
+        return;
+    }
+    free(plan->sequence);
+    free(plan->positions);
+    free(plan->codes);
+    free(plan);
+}
+
 void free_embedding_result(EmbeddingResult *result) {
     if (!result) {
         return;
@@ -180,11 +729,10 @@ static int base_index(char base) {
     }
 }
 
-static int select_allele(char reference,
-                         int bit,
-                         const CandidateSNP *candidate,
-                         char *out_allele,
-                         char **out_error) {
+static const char *select_allele(char reference,
+                                 int bit,
+                                 const CandidateSNP *candidate,
+                                 char *out_allele) {
     char normalized[4];
     size_t normalized_count = 0;
     size_t i;
@@ -192,7 +740,7 @@ static int select_allele(char reference,
 
     ref_index = base_index(reference);
     if (ref_index < 0) {
-        return set_error(out_error, "Unsupported reference nucleotide.");
+        return "Unsupported reference nucleotide.";
     }
 
     if (candidate && candidate->alternates && candidate->num_alternates > 0) {
@@ -219,27 +767,275 @@ static int select_allele(char reference,
 
     if (normalized_count >= 2) {
         *out_allele = normalized[bit & 1];
-        return 0;
+        return NULL;
     }
 
     if (normalized_count == 1) {
         if (bit == 0) {
             *out_allele = normalized[0];
-            return 0;
+            return NULL;
         }
         /* Need an alternate distinct from both reference and provided allele. */
         if (DEFAULT_ALLELE_MAP[ref_index][0] != normalized[0]) {
             *out_allele = DEFAULT_ALLELE_MAP[ref_index][0];
-            return 0;
+            return NULL;
         }
         if (DEFAULT_ALLELE_MAP[ref_index][1] != normalized[0]) {
             *out_allele = DEFAULT_ALLELE_MAP[ref_index][1];
-            return 0;
+            return NULL;
         }
-        return set_error(out_error, "Unable to determine fallback allele.");
+        return "Unable to determine fallback allele.";
     }
 
     *out_allele = DEFAULT_ALLELE_MAP[ref_index][bit & 1];
+    return NULL;
+}
+
+/*
+ * Validates a single candidate against `lookup` and chooses the allele encoding
+ * `bit`. Returns NULL on success or a static error message; it never allocates,
+ * so it is safe to call from parallel regions.
+ */
+static const char *embed_bit(const char *lookup,
+                             size_t seq_len,
+                             const CandidateSNP *candidate,
+                             int bit,
+                             EmbeddedAllele *out_allele) {
+    size_t pos = candidate->position;
+    char expected = (char)toupper((unsigned char)candidate->reference);
+    const char *message;
+    char allele;
+
+    if (pos >= seq_len) {
+        return "Candidate SNP position outside sequence bounds.";
+    }
+
+    if ((char)toupper((unsigned char)lookup[pos]) != expected) {
+        return "Reference base does not match sequence at candidate position.";
+    }
+
+    message = select_allele(expected, bit, candidate, &allele);
+    if (message) {
+        return message;
+    }
+
+    out_allele->position = pos;
+    out_allele->reference = expected;
+    out_allele->allele = allele;
+    out_allele->bit = bit;
+    return NULL;
+}
+
+/*
+ * Shared argument validation and allocation for the embedding entry points.
+ * On success `*out_mutated` holds a copy of `sequence` and `*out_alleles` room
+ * for one entry per payload bit (NULL for an empty payload).
+ */
+static int prepare_embedding(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             const EmbeddingResult *out_result,
+                             size_t *out_seq_len,
+                             char **out_mutated,
+                             EmbeddedAllele **out_alleles,
+                             char **out_error) {
+    size_t seq_len;
+    size_t bit_count;
+    char *mutated;
+    EmbeddedAllele *alleles;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+
+    if (!sequence || !candidates || !out_result) {
+        return set_error(out_error, "Invalid argument: NULL pointer supplied.");
+    }
+
+    if (payload_len > 0 && !payload) {
+        return set_error(out_error, "Invalid argument: payload data is NULL.");
+    }
+
+    seq_len = strlen(sequence);
+    bit_count = payload_len * 8;
+
+    if (bit_count > num_candidates) {
+        return set_error(out_error,
+                         "Insufficient candidate SNPs for payload capacity.");
+    }
+
+    mutated = (char *)malloc(seq_len + 1);
+    if (!mutated) {
+        return set_error(out_error, "Failed to allocate memory for sequence.");
+    }
+    memcpy(mutated, sequence, seq_len + 1);
+
+    if (bit_count > 0) {
+        alleles = (EmbeddedAllele *)calloc(bit_count, sizeof(EmbeddedAllele));
+        if (!alleles) {
+            free(mutated);
+            return set_error(out_error, "Failed to allocate memory for alleles.");
+        }
+    } else {
+        alleles = NULL;
+    }
+
+    *out_seq_len = seq_len;
+    *out_mutated = mutated;
+    *out_alleles = alleles;
     return 0;
 }
 
+/* Atomically claims `pos`; returns 1 if this call set the claim bit. */
+static int claim_position(SharedSequence *shared, size_t pos) {
+    uint64_t mask = (uint64_t)1 << (pos % 64);
+    uint64_t previous = atomic_fetch_or_explicit(&shared->claimed[pos / 64],
+                                                 mask,
+                                                 memory_order_acquire);
+    return (previous & mask) == 0;
+}
+
+/* Sets the bit for `pos` in `bitmap`; returns 1 if it was already set. */
+static int mark_position(_Atomic uint64_t *bitmap, size_t pos) {
+    uint64_t mask = (uint64_t)1 << (pos % 64);
+    return (atomic_fetch_or_explicit(&bitmap[pos / 64], mask, memory_order_relaxed) & mask) != 0;
+}
+
+/* Clears the claim bit for `pos`, publishing any restored base first. */
+static void release_position(SharedSequence *shared, size_t pos) {
+    uint64_t mask = (uint64_t)1 << (pos % 64);
+    atomic_fetch_and_explicit(&shared->claimed[pos / 64], ~mask, memory_order_release);
+}
+
+/*
+ * Inverse of `embed_bit`: reads the base at a candidate position and returns
+ * the bit whose allele it matches. Never allocates.
+ */
+static const char *extract_bit(const char *sequence,
+                               size_t seq_len,
+                               const CandidateSNP *candidate,
+                               int *out_bit) {
+    size_t pos = candidate->position;
+    char reference = (char)toupper((unsigned char)candidate->reference);
+    char observed;
+    char allele;
+    int bit;
+
+    if (pos >= seq_len) {
+        return "Candidate SNP position outside sequence bounds.";
+    }
+
+    observed = (char)toupper((unsigned char)sequence[pos]);
+    for (bit = 0; bit < 2; ++bit) {
+        const char *message = select_allele(reference, bit, candidate, &allele);
+        if (message) {
+            return message;
+        }
+        if (allele == observed) {
+            *out_bit = bit;
+            return NULL;
+        }
+    }
+    return UNREADABLE_ALLELE_MESSAGE;
+}
+
+/* 64-bit finalizer from SplitMix64, used as the Feistel round function. */
+static uint64_t mix64(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+/*
+ * Shared implementation of the extraction entry points. When `tolerant` is
+ * set, unreadable candidates decode as 0 and are counted instead of failing.
+ */
+static int extract_payload(const char *sequence,
+                           const CandidateSNP *candidates,
+                           size_t num_candidates,
+                           const CandidatePermutation *permutation,
+                           uint8_t *out_payload,
+                           size_t payload_len,
+                           int tolerant,
+                           size_t *out_unreadable,
+                           char **out_error) {
+    size_t seq_len;
+    size_t unreadable = 0;
+    size_t error_index;
+    const char *error_message = NULL;
+    long index;
+
+    if (out_error) {
+        *out_error = NULL;
+    }
+    if (out_unreadable) {
+        *out_unreadable = 0;
+    }
+
+    if (!sequence || !candidates || (payload_len > 0 && !out_payload)) {
+        return set_error(out_error, "Invalid argument: NULL pointer supplied.");
+    }
+
+    if (payload_len * 8 > num_candidates) {
+        return set_error(out_error,
+                         "Insufficient candidate SNPs for payload capacity.");
+    }
+
+    if (permutation && permutation->domain != num_candidates) {
+        return set_error(out_error, "Candidate permutation does not match candidate count.");
+    }
+
+    seq_len = strlen(sequence);
+
+    /* One payload byte per iteration keeps every output byte thread-private. */
+    error_index = payload_len;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+ : unreadable) \
+    if (payload_len * 8 >= EMBED_PARALLEL_MIN_BITS)
+#endif
+    for (index = 0; index < (long)payload_len; ++index) {
+        size_t byte_index = (size_t)index;
+        uint8_t value = 0;
+        size_t k;
+
+        for (k = 0; k < 8; ++k) {
+            size_t i = byte_index * 8 + k;
+            size_t slot = permutation ? candidate_permutation_apply(permutation, i) : i;
+            int bit = 0;
+            const char *message = extract_bit(sequence, seq_len, &candidates[slot], &bit);
+
+            if (message && tolerant && message == UNREADABLE_ALLELE_MESSAGE) {
+                unreadable++;
+                bit = 0;
+                message = NULL;
+            }
+            if (message) {
+#ifdef _OPENMP
+#pragma omp critical(extract_bitstream_error)
+#endif
+                {
+                    if (byte_index < error_index) {
+                        error_index = byte_index;
+                        error_message = message;
+                    }
+                }
+                break;
+            }
+            value = (uint8_t)((value << 1) | bit);
+        }
+        out_payload[byte_index] = value;
+    }
+
+    if (out_unreadable) {
+        *out_unreadable = unreadable;
+    }
+    if (error_message) {
+        return set_error(out_error, error_message);
+    }
+    return 0;
+}
@@ -36,6 +36,40 @@ typedef struct {
     size_t num_alleles;         /* Number of encoded SNPs. */
 } EmbeddingResult;
 
+/*
+ * Genome shared by several concurrent embedding jobs. Positions are claimed
+ * through an atomic bitmap so that no two payloads overwrite the same base.
+ */
+typedef struct SharedSequence SharedSequence;
+
+/* How `embed_bitstream_shared` reacts to a candidate already claimed. */
+typedef enum {
+    EMBED_CONFLICT_FAIL = 0, /* Abort the job and report the conflict. */
+    EMBED_CONFLICT_SKIP = 1  /* Route the bit to the next unclaimed candidate. */
+} EmbedConflictPolicy;
+
+/*
+ * Below this many payload bits the parallel embedding and extraction paths
+ * run on one thread; spawning a team costs more than the work saved.
+ */
+#define EMBED_PARALLEL_MIN_BITS 4096
+
+/* Number of key bytes and Feistel rounds used by CandidatePermutation. */
+#define CANDIDATE_PERMUTATION_KEY_BYTES 16
+#define CANDIDATE_PERMUTATION_ROUNDS 6
+
+/*
+ * Keyed, format-preserving permutation of the candidate index domain
+ * [0, domain). Payload bit i is carried by candidate
+ * `candidate_permutation_apply(perm, i)`, which spreads a payload across the
+ * whole candidate list without materializing a shuffled copy of it.
+ */
+typedef struct {
+    uint64_t domain;    /* Number of candidate indices being permuted. */
+    unsigned half_bits; /* Width in bits of each Feistel half. */
+    uint64_t round_keys[CANDIDATE_PERMUTATION_ROUNDS];
+} CandidatePermutation;
+
 /* Returns the number of SNPs available for embedding. */
 size_t calculate_capacity(const CandidateSNP *candidates, size_t num_candidates);
 
@@ -52,6 +86,158 @@ int embed_bitstream(const char *sequence,
                     EmbeddingResult *out_result,
                     char **out_error);
 
+/*
+ * Parallel variant of `embed_bitstream` for very large payloads. Payload bits
+ * are split into contiguous ranges, one per OpenMP thread, and every thread
+ * writes disjoint entries of the output sequence and allele array. References
+ * are checked against the original sequence, and any position used by two
+ * bits is rejected. The serial call checks against its partially embedded
+ * copy instead, so it may accept a repeated position (and overwrite the
+ * earlier bit) when the second candidate's reference equals the allele written
+ * first. For candidate lists with distinct positions the output is identical
+ * to the serial call. On failure the error for the lowest failing bit is
+ * reported. Pass `num_threads <= 0` to use the OpenMP default. Builds without
+ * OpenMP run serially.
+ */
+int embed_bitstream_parallel(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             int num_threads,
+                             EmbeddingResult *out_result,
+                             char **out_error);
+
+/*
+ * Derives a permutation of [0, num_candidates) from `key`
+ * (CANDIDATE_PERMUTATION_KEY_BYTES bytes). Returns 0 on success or -1 when the
+ * arguments are invalid.
+ */
+int candidate_permutation_init(CandidatePermutation *perm,
+                               size_t num_candidates,
+                               const uint8_t *key);
+
+/* Maps a payload bit index to the candidate index that carries it. */
+size_t candidate_permutation_apply(const CandidatePermutation *perm, size_t index);
+
+/*
+ * Same as `embed_bitstream_parallel`, but bit i is written to candidate
+ * `candidate_permutation_apply(permutation, i)`. The permutation must have
+ * been initialised for `num_candidates`. A NULL permutation keeps the
+ * identity mapping.
+ */
+int embed_bitstream_permuted(const char *sequence,
+                             const CandidateSNP *candidates,
+                             size_t num_candidates,
+                             const uint8_t *payload,
+                             size_t payload_len,
+                             const CandidatePermutation *permutation,
+                             int num_threads,
+                             EmbeddingResult *out_result,
+                             char **out_error);
+
+/*
+ * Recovers `payload_len` bytes from an embedded sequence by comparing each
+ * candidate position with the alleles chosen during embedding. Pass the same
+ * candidates and permutation (or NULL) that were used to embed. Bytes are
+ * decoded in parallel when OpenMP is available. Returns 0 on success or -1
+ * when a candidate does not carry a recognizable payload allele.
+ */
+int extract_bitstream(const char *sequence,
+                      const CandidateSNP *candidates,
+                      size_t num_candidates,
+                      const CandidatePermutation *permutation,
+                      uint8_t *out_payload,
+                      size_t payload_len,
+                      char **out_error);
+
+/*
+ * Like `extract_bitstream`, but a candidate whose base matches neither allele
+ * decodes as 0 instead of failing. `out_unreadable` (optional) receives the
+ * number of such candidates. Intended for callers that repair the stream
+ * afterwards, such as the allele parity decoder.
+ */
+int extract_bitstream_tolerant(const char *sequence,
+                               const CandidateSNP *candidates,
+                               size_t num_candidates,
+                               const CandidatePermutation *permutation,
+                               uint8_t *out_payload,
+                               size_t payload_len,
+                               size_t *out_unreadable,
+                               char **out_error);
+
+/*
+ * Creates a shared, mutable copy of `sequence` with an empty claim bitmap.
+ * Returns NULL on failure. Release with `shared_sequence_destroy`.
+ */
+SharedSequence *shared_sequence_create(const char *sequence, char **out_error);
+
+/* Current contents of the shared sequence, including embedded payloads. */
+const char *shared_sequence_data(const SharedSequence *shared);
+
+/* Releases a shared sequence and its claim bitmap. */
+void shared_sequence_destroy(SharedSequence *shared);
+
+/*
+ * Embeds a payload into a shared sequence. Safe to call concurrently from
+ * several threads on the same `shared` object: every candidate position is
+ * claimed atomically before it is written. With EMBED_CONFLICT_SKIP a claimed
+ * candidate is skipped and the bit moves to the next candidate in the list,
+ * so `out_result->alleles` records where each bit actually landed. On failure
+ * the job's writes are reverted and its claims released. The mutated sequence
+ * stays in `shared`; `out_result->sequence` is set to NULL. `out_conflicts`
+ * (optional) receives the number of claimed candidates encountered.
+ */
+int embed_bitstream_shared(SharedSequence *shared,
+                           const CandidateSNP *candidates,
+                           size_t num_candidates,
+                           const uint8_t *payload,
+                           size_t payload_len,
+                           EmbedConflictPolicy policy,
+                           EmbeddingResult *out_result,
+                           size_t *out_conflicts,
+                           char **out_error);
+
+/*
+ * Candidate layout compiled once for a sequence. Every candidate is validated
+ * and both of its payload alleles are resolved when the plan is built, so
+ * applying a payload is a gather over the plan and a scatter into a copy of
+ * the sequence.
+ */
+typedef struct EmbeddingPlan EmbeddingPlan;
+
+/*
+ * Validates all candidates against `sequence` (bounds, reference base,
+ * distinct positions, allele choice) and stores their positions and packed
+ * 2-bit allele codes with a private copy of the sequence. Unlike
+ * `embed_bitstream`, a candidate is rejected even if no payload ends up using
+ * it. Returns NULL on failure. Release with `embedding_plan_free`.
+ */
+EmbeddingPlan *embedding_plan_compile(const char *sequence,
+                                      const CandidateSNP *candidates,
+                                      size_t num_candidates,
+                                      char **out_error);
+
+/* Number of candidates, and therefore payload bits, held by the plan. */
+size_t embedding_plan_capacity(const EmbeddingPlan *plan);
+
+/*
+ * Embeds a payload using a compiled plan. The output matches
+ * `embed_bitstream_permuted` called with the plan's sequence and candidates.
+ * Only the payload size and permutation are checked here. Returns 0 on success
+ * or -1 on failure.
+ */
+int embedding_plan_apply(const EmbeddingPlan *plan,
+                         const uint8_t *payload,
+                         size_t payload_len,
+                         const CandidatePermutation *permutation,
+                         int num_threads,
+                         EmbeddingResult *out_result,
+                         char **out_error);
+
+/* Releases a plan created by `embedding_plan_compile`. */
+void embedding_plan_free(EmbeddingPlan *plan);
+
 /* Releases memory allocated inside an EmbeddingResult. */
 void free_embedding_result(EmbeddingResult *result);
 
@@ -0,0 +1,53 @@
+#ifndef RECORD_SORT_H
+#define RECORD_SORT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "sequence.h"
+
+typedef enum {
+    SORT_KEY_NONE = 0,
+    SORT_KEY_CHROMOSOME,
+    SORT_KEY_RECORD_ID
+} SortKey;
+
+/* Accepts "chromosome" (contig, then start) or "record_id". */
+int parse_sort_key(const char *name, SortKey *key);
+
+/* Canonical name of `key`: "none", "chromosome" or "record_id". */
+const char *sort_key_name(SortKey key);
+
+/*
+ * Fills `order` with the indices begin .. begin + count - 1 sorted by `key`.
+ * Ties keep input order. Uses a parallel merge sort built on OpenMP tasks.
+ */
+int sort_record_order(const SequenceRecord *records, size_t begin, size_t count, SortKey key, size_t *order);
+
+/*
+ * Sorted runs spilled to temporary files for external merge sorting. Every run
+ * line is "<sort key>\t<output row>", written in key order.
+ */
+typedef struct {
+    FILE **files;
+    size_t count;
+    size_t capacity;
+} SortRuns;
+
+void sort_runs_init(SortRuns *runs);
+void sort_runs_free(SortRuns *runs);
+
+/*
+ * Opens a new, empty run. When MAX_MERGE_FAN_IN runs are already open they are
+ * first merged into one, which bounds the number of open temporary files.
+ * Returns NULL on failure.
+ */
+FILE *sort_runs_begin(SortRuns *runs);
+
+/* Writes the sort-key prefix of a run line for `records[index]`. */
+int sort_runs_write_key(FILE *run, const SequenceRecord *records, size_t index, SortKey key);
+
+/* K-way merges all runs into `output`, stripping the key prefix from each line. */
+int sort_runs_merge(SortRuns *runs, FILE *output);
+
+#endif /* RECORD_SORT_H */
@@ -0,0 +1,42 @@
+#ifndef REFERENCE_GENOME_H
+#define REFERENCE_GENOME_H
+
+#include <stddef.h>
+
+typedef struct {
+    char *name;
+    size_t offset;
+    size_t length;
+    size_t line_bases;
+    size_t line_bytes;
+} ReferenceContig;
+
+typedef struct {
+    const char *data;
+    size_t size;
+    ReferenceContig *contigs;
+    size_t count;
+} ReferenceGenome;
+
+/*
+ * Memory-maps a FASTA file and indexes its contigs. Every contig must use a
+ * constant line width, as required by samtools faidx. Coordinates used by the
+ * functions below are zero-based and half-open: [start, end).
+ */
+int reference_genome_open(const char *path, ReferenceGenome *genome);
+void reference_genome_close(ReferenceGenome *genome);
+
+const ReferenceContig *reference_genome_find(const ReferenceGenome *genome, const char *name);
+
+/*
+ * Returns 1 when the interval exists and equals `bases` exactly. The
+ * comparison is case-sensitive so that `reference_genome_fetch` returns the
+ * same bytes: soft-masked (lower-case) FASTA bases only match lower-case input.
+ */
+int reference_genome_matches(const ReferenceGenome *genome, const char *contig, size_t start, size_t end,
+                             const char *bases);
+
+/* Copies the bases of an interval into a newly allocated string, or returns NULL. */
+char *reference_genome_fetch(const ReferenceGenome *genome, const char *contig, size_t start, size_t end);
+
+#endif /* REFERENCE_GENOME_H */
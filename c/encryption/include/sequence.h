@@ -8,6 +8,9 @@ typedef struct {
     char *positions;
     char *reference;
     char *sequence;
+    char *contig; /* Set when the row has a contig and a start coordinate. */
+    size_t start;
+    size_t end;   /* Equals `start` when the row has no valid end (no interval). */
 } SequenceRecord;
 
 typedef struct {
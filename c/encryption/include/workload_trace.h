@@ -0,0 +1,40 @@
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sequence.h"
+
+/* Stage timings of one record, filled in by the encryption loop. */
+typedef struct {
+    uint64_t start_ns; /* Monotonic time the record was picked up. */
+    uint64_t plaintext_ns;
+    uint64_t cipher_ns;
+    uint64_t encode_ns;
+    size_t plaintext_bytes;
+    int thread;
+    int elided;
+} RecordTiming;
+
+/* Options and phase timings of the captured run. */
+typedef struct {
+    int threads;
+    const char *sort_by; /* "none", "chromosome" or "record_id". */
+    size_t sort_memory_mb;
+    int reference_fasta;
+    int latency_report;
+    uint64_t load_ns;
+    uint64_t run_ns;
+} WorkloadTraceSettings;
+
+/*
+ * Writes a sanitized workload trace: run options, phase timings and, per
+ * record, field lengths, column presence, contig and start ranks, elision
+ * and stage timings. No bases, positions, identifiers, contig names or
+ * coordinates are written. `c/bench/workload_replay` regenerates shape-identical inputs from it.
+ */
+int workload_trace_write(const char *path, const WorkloadTraceSettings *settings,
+                         const SequenceCollection *collection, const RecordTiming *timings);
+
+#endif /* WORKLOAD_TRACE_H */
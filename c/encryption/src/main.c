@@ -3,18 +3,29 @@
  * Reviewed and modified by Viru Repalle.         
  * */
 
+#include "latency_histogram.h"
+#include "record_sort.h"
+#include "reference_genome.h"
 #include "sequence.h"
+#include "workload_trace.h"
 
 #include <errno.h>
 #include <omp.h>
 #include <sodium.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #define NONCE_SIZE crypto_stream_xchacha20_NONCEBYTES
 #define KEY_SIZE crypto_stream_xchacha20_KEYBYTES
 
+/* Worker threads when --threads is not given; see `bench --thread-sweep`. */
+#ifndef DEFAULT_THREAD_COUNT
+#define DEFAULT_THREAD_COUNT 7
+#endif
+
 typedef struct {
     char *nonce_dna;
     char *ciphertext_dna;
@@ -128,13 +139,35 @@ static char *binary_to_dna(const unsigned char *data, size_t length) {
     return output;
 }
 
-static char *build_plaintext(const SequenceRecord *record) {
+static char *build_plaintext(const SequenceRecord *record, const ReferenceGenome *genome, int *elided) {
     if (!record || !record->sequence) {
         return NULL;
     }
+    if (elided) {
+        *elided = 0;
+    }
     if (record->positions || record->reference) {
         const char *positions = record->positions ? record->positions : "";
         const char *reference = record->reference ? record->reference : "";
+        /*
+         * When the reference bases are identical to the mapped genome, store the
+         * interval instead; the bases can be re-materialized on decryption.
+         */
+        if (genome && record->contig && record->reference &&
+            reference_genome_matches(genome, record->contig, record->start, record->end, record->reference)) {
+            size_t required = snprintf(NULL, 0, "Hotspot Positions: %s\nReference Interval: %s:%zu-%zu\nSequence: %s",
+                                       positions, record->contig, record->start, record->end, record->sequence);
+            char *buffer = (char *)malloc(required + 1);
+            if (!buffer) {
+                return NULL;
+            }
+            snprintf(buffer, required + 1, "Hotspot Positions: %s\nReference Interval: %s:%zu-%zu\nSequence: %s",
+                     positions, record->contig, record->start, record->end, record->sequence);
+            if (elided) {
+                *elided = 1;
+            }
+            return buffer;
+        }
         size_t required = snprintf(NULL, 0, "Hotspot Positions: %s\nReference: %s\nSequence: %s", positions, reference,
                                    record->sequence);
         char *buffer = (char *)malloc(required + 1);
@@ -148,19 +181,83 @@ static char *build_plaintext(const SequenceRecord *record) {
     return duplicate_string(record->sequence);
 }
 
+/* Per-thread latency (ns) and size histograms, merged after encryption. */
+typedef struct {
+    LatencyHistogram plaintext;
+    LatencyHistogram cipher;
+    LatencyHistogram encode;
+    LatencyHistogram total;
+    LatencyHistogram plaintext_bytes;
+} StageHistograms;
+
+static StageHistograms *stage_histograms_create(size_t count) {
+    StageHistograms *histograms = (StageHistograms *)malloc(count * sizeof(StageHistograms));
+    if (!histograms) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        latency_histogram_init(&histograms[i].plaintext);
+        latency_histogram_init(&histograms[i].cipher);
+        latency_histogram_init(&histograms[i].encode);
+        latency_histogram_init(&histograms[i].total);
+        latency_histogram_init(&histograms[i].plaintext_bytes);
+    }
+    return histograms;
+}
+
+static void stage_histograms_report(StageHistograms *histograms, size_t count) {
+    StageHistograms *merged = &histograms[0];
+    for (size_t i = 1; i < count; ++i) {
+        latency_histogram_merge(&merged->plaintext, &histograms[i].plaintext);
+        latency_histogram_merge(&merged->cipher, &histograms[i].cipher);
+        latency_histogram_merge(&merged->encode, &histograms[i].encode);
+        latency_histogram_merge(&merged->total, &histograms[i].total);
+        latency_histogram_merge(&merged->plaintext_bytes, &histograms[i].plaintext_bytes);
+    }
+    fprintf(stderr, "Per-record latency:\n");
+    latency_histogram_print(stderr, "  build_plaintext", &merged->plaintext, 1e-3, "us");
+    latency_histogram_print(stderr, "  xchacha20", &merged->cipher, 1e-3, "us");
+    latency_histogram_print(stderr, "  dna_encode", &merged->encode, 1e-3, "us");
+    latency_histogram_print(stderr, "  record_total", &merged->total, 1e-3, "us");
+    fprintf(stderr, "Per-record size:\n");
+    latency_histogram_print(stderr, "  plaintext", &merged->plaintext_bytes, 1.0, "B");
+}
+
 typedef struct {
     const char *input_path;
     const char *key_path;
     const char *output_path;
+    const char *reference_path;
+    SortKey sort_key;
+    size_t sort_memory_mb;
+    int latency_report;
+    const char *capture_trace;
     int threads;
 } Options;
 
 static void print_usage(const char *program) {
     fprintf(stderr,
-            "Usage: %s --input <snp_hotspots_strings.tsv> --key <key.hex> --output <encrypted.tsv> [--threads N]\n",
+            "Usage: %s --input <snp_hotspots_strings.tsv> --key <key.hex> --output <encrypted.tsv> [--threads N]\n"
+            "          [--reference-fasta <genome.fa>] [--sort-by chromosome|record_id] [--sort-memory MB]\n"
+            "          [--latency-report] [--capture-trace <trace.tsv>]\n",
             program);
 }
 
+/* Parses a positive MB count whose byte size fits in size_t. */
+static int parse_megabytes(const char *value, size_t *out) {
+    if (!value || *value == '\0' || value[0] == '-') {
+        return -1;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed == 0 || parsed > SIZE_MAX / (1024 * 1024)) {
+        return -1;
+    }
+    *out = (size_t)parsed;
+    return 0;
+}
+
 static int parse_arguments(int argc, char **argv, Options *options) {
     if (!options) {
         return -1;
@@ -168,7 +265,12 @@ static int parse_arguments(int argc, char **argv, Options *options) {
     options->input_path = NULL;
     options->key_path = NULL;
     options->output_path = NULL;
-    options->threads = 7;
+    options->reference_path = NULL;
+    options->sort_key = SORT_KEY_NONE;
+    options->sort_memory_mb = 1024;
+    options->latency_report = 0;
+    options->capture_trace = NULL;
+    options->threads = DEFAULT_THREAD_COUNT;
 
     for (int i = 1; i < argc; ++i) {
         const char *arg = argv[i];
@@ -178,6 +280,24 @@ static int parse_arguments(int argc, char **argv, Options *options) {
             options->key_path = argv[++i];
         } else if (strcmp(arg, "--output") == 0 && i + 1 < argc) {
             options->output_path = argv[++i];
+        } else if (strcmp(arg, "--reference-fasta") == 0 && i + 1 < argc) {
+            options->reference_path = argv[++i];
+        } else if (strcmp(arg, "--sort-by") == 0 && i + 1 < argc) {
+            if (parse_sort_key(argv[++i], &options->sort_key) != 0) {
+                fprintf(stderr, "Unknown sort key: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(arg, "--sort-memory") == 0 && i + 1 < argc) {
+            if (parse_megabytes(argv[++i], &options->sort_memory_mb) != 0) {
+                fprintf(stderr, "Invalid --sort-memory value: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(arg, "--latency-report") == 0) {
+            options->latency_report = 1;
+        } else if (strcmp(arg, "--capture-trace") == 0 && i + 1 < argc) {
+            options->capture_trace = argv[++i];
         } else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
             options->threads = atoi(argv[++i]);
         } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
@@ -196,65 +316,38 @@ static int parse_arguments(int argc, char **argv, Options *options) {
         return -1;
     }
     if (options->threads <= 0) {
-        options->threads = 7;
+        options->threads = DEFAULT_THREAD_COUNT;
     }
     return 0;
 }
 
-int main(int argc, char **argv) {
-    Options options;
-    int arg_status = parse_arguments(argc, argv, &options);
-    if (arg_status != 0) {
-        return arg_status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
-    }
-
-    if (sodium_init() < 0) {
-        fprintf(stderr, "Failed to initialise libsodium.\n");
-        return EXIT_FAILURE;
-    }
-
-    unsigned char key[KEY_SIZE];
-    if (load_key_from_hex(options.key_path, key) != 0) {
-        return EXIT_FAILURE;
-    }
-
-    SequenceCollection collection;
-    if (sequence_collection_init(&collection) != 0) {
-        fprintf(stderr, "Failed to initialise sequence collection.\n");
-        return EXIT_FAILURE;
-    }
-
-    if (load_sequence_records(options.input_path, &collection) != 0) {
-        sequence_collection_free(&collection);
-        return EXIT_FAILURE;
-    }
-
-    if (collection.count == 0) {
-        fprintf(stderr, "No sequences were loaded from %s.\n", options.input_path);
-        sequence_collection_free(&collection);
-        return EXIT_FAILURE;
-    }
-
-    EncryptionResult *results = (EncryptionResult *)calloc(collection.count, sizeof(EncryptionResult));
-    if (!results) {
-        fprintf(stderr, "Failed to allocate memory for encryption results.\n");
-        sequence_collection_free(&collection);
-        return EXIT_FAILURE;
-    }
-
-    omp_set_num_threads(options.threads);
-
+/*
+ * Encrypts records [begin, end) in parallel into results[0 .. end - begin).
+ * When `histograms` is non-NULL each thread records stage timings into its own
+ * entry, indexed by OpenMP thread number, so no locking is needed. When
+ * `timings` is non-NULL the same timings are stored per record (indexed by
+ * record) for --capture-trace.
+ */
+static int encrypt_records(const SequenceCollection *collection, size_t begin, size_t end,
+                           const unsigned char key[KEY_SIZE], const ReferenceGenome *reference,
+                           EncryptionResult *results, size_t *elided_out, StageHistograms *histograms,
+                           RecordTiming *timings) {
     int encountered_error = 0;
-    size_t total_records = collection.count;
-#pragma omp parallel for schedule(dynamic)
-    for (long index = 0; index < (long)total_records; ++index) {
+    size_t elided_records = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : elided_records)
+    for (long index = (long)begin; index < (long)end; ++index) {
         size_t i = (size_t)index;
-        const SequenceRecord *record = &collection.records[i];
+        const SequenceRecord *record = &collection->records[i];
         EncryptionResult result = {0};
         size_t plaintext_length = 0;
         unsigned char *ciphertext = NULL;
         unsigned char nonce[NONCE_SIZE];
-        char *plaintext = build_plaintext(record);
+        StageHistograms *local = histograms ? &histograms[omp_get_thread_num()] : NULL;
+        int timed = local || timings;
+        uint64_t started = timed ? latency_now_ns() : 0;
+        int elided = 0;
+        char *plaintext = build_plaintext(record, reference, &elided);
+        uint64_t built = timed ? latency_now_ns() : 0;
         if (!plaintext) {
 #pragma omp critical
             {
@@ -285,10 +378,29 @@ int main(int argc, char **argv) {
             free(plaintext);
             continue;
         }
+        uint64_t encrypted = timed ? latency_now_ns() : 0;
         result.nonce_dna = binary_to_dna(nonce, sizeof nonce);
         result.ciphertext_dna = binary_to_dna(ciphertext, plaintext_length);
         free(ciphertext);
         free(plaintext);
+        uint64_t finished = timed ? latency_now_ns() : 0;
+        if (local) {
+            latency_histogram_record(&local->plaintext, built - started);
+            latency_histogram_record(&local->cipher, encrypted - built);
+            latency_histogram_record(&local->encode, finished - encrypted);
+            latency_histogram_record(&local->total, finished - started);
+            latency_histogram_record(&local->plaintext_bytes, plaintext_length);
+        }
+        if (timings) {
+            RecordTiming *timing = &timings[i];
+            timing->start_ns = started;
+            timing->plaintext_ns = built - started;
+            timing->cipher_ns = encrypted - built;
+            timing->encode_ns = finished - encrypted;
+            timing->plaintext_bytes = plaintext_length;
+            timing->thread = omp_get_thread_num();
+            timing->elided = elided;
+        }
         if (!result.nonce_dna || !result.ciphertext_dna) {
 #pragma omp critical
             {
@@ -300,11 +412,263 @@ int main(int argc, char **argv) {
             continue;
         }
         result.status = 0;
-        results[i] = result;
+        results[i - begin] = result;
+        elided_records += (size_t)elided;
+    }
+    *elided_out += elided_records;
+    return encountered_error ? -1 : 0;
+}
+
+static int write_row(FILE *output, const SequenceRecord *record, const EncryptionResult *result) {
+    const char *identifier = record->identifier ? record->identifier : "record";
+    return fprintf(output, "%s\t%s\t%s\n", identifier, result->nonce_dna, result->ciphertext_dna) < 0 ? -1 : 0;
+}
+
+/* Rough size of a record's output row, used to decide when sorting must spill. */
+static size_t estimate_row_bytes(const SequenceRecord *record) {
+    size_t plaintext = 64 + strlen(record->sequence);
+    plaintext += record->positions ? strlen(record->positions) : 0;
+    plaintext += record->reference ? strlen(record->reference) : 0;
+    return (record->identifier ? strlen(record->identifier) : 8) + NONCE_SIZE * 4 + plaintext * 4 + 3;
+}
+
+/*
+ * Writes the records sorted by options->sort_key. When the estimated output
+ * fits within --sort-memory the records are encrypted and sorted in memory;
+ * otherwise each memory-sized chunk is encrypted, sorted and spilled as a run,
+ * and the runs are k-way merged so only one chunk of results is ever held.
+ */
+static int write_sorted_output(const Options *options, const SequenceCollection *collection,
+                               const unsigned char key[KEY_SIZE], const ReferenceGenome *reference, FILE *output,
+                               size_t *elided_out, StageHistograms *histograms, RecordTiming *timings) {
+    size_t budget = options->sort_memory_mb * 1024 * 1024;
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < collection->count; ++i) {
+        total_bytes += estimate_row_bytes(&collection->records[i]);
+    }
+    int spill = total_bytes > budget;
+
+    SortRuns runs;
+    sort_runs_init(&runs);
+    int status = 0;
+    size_t begin = 0;
+    while (status == 0 && begin < collection->count) {
+        size_t end = collection->count;
+        if (spill) {
+            size_t chunk_bytes = 0;
+            end = begin;
+            while (end < collection->count && (end == begin || chunk_bytes < budget)) {
+                chunk_bytes += estimate_row_bytes(&collection->records[end]);
+                end++;
+            }
+        }
+        size_t count = end - begin;
+        EncryptionResult *results = (EncryptionResult *)calloc(count, sizeof(EncryptionResult));
+        size_t *order = (size_t *)malloc(count * sizeof(size_t));
+        if (!results || !order) {
+            fprintf(stderr, "Failed to allocate memory for encryption results.\n");
+            free(results);
+            free(order);
+            status = -1;
+            break;
+        }
+        if (encrypt_records(collection, begin, end, key, reference, results, elided_out, histograms, timings) != 0 ||
+            sort_record_order(collection->records, begin, count, options->sort_key, order) != 0) {
+            status = -1;
+        }
+        FILE *target = output;
+        if (status == 0 && spill) {
+            target = sort_runs_begin(&runs);
+            status = target ? 0 : -1;
+        }
+        for (size_t k = 0; status == 0 && k < count; ++k) {
+            size_t i = order[k];
+            if (spill && sort_runs_write_key(target, collection->records, i, options->sort_key) != 0) {
+                status = -1;
+                break;
+            }
+            status = write_row(target, &collection->records[i], &results[i - begin]);
+        }
+        free_results(results, count);
+        free(order);
+        begin = end;
+    }
+
+    if (status == 0 && spill) {
+        fprintf(stderr, "Merging %zu sorted runs.\n", runs.count);
+        status = sort_runs_merge(&runs, output);
+    }
+    sort_runs_free(&runs);
+    return status;
+}
+
+/* Writes the --capture-trace file once the run has finished. */
+static int write_capture(const Options *options, const SequenceCollection *collection, const RecordTiming *timings,
+                         uint64_t load_ns, uint64_t run_ns) {
+    WorkloadTraceSettings settings = {
+        .threads = options->threads,
+        .sort_by = sort_key_name(options->sort_key),
+        .sort_memory_mb = options->sort_memory_mb,
+        .reference_fasta = options->reference_path != NULL,
+        .latency_report = options->latency_report,
+        .load_ns = load_ns,
+        .run_ns = run_ns,
+    };
+    return workload_trace_write(options->capture_trace, &settings, collection, timings);
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    int arg_status = parse_arguments(argc, argv, &options);
+    if (arg_status != 0) {
+        return arg_status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    if (sodium_init() < 0) {
+        fprintf(stderr, "Failed to initialise libsodium.\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned char key[KEY_SIZE];
+    if (load_key_from_hex(options.key_path, key) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    SequenceCollection collection;
+    if (sequence_collection_init(&collection) != 0) {
+        fprintf(stderr, "Failed to initialise sequence collection.\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t load_started = latency_now_ns();
+    if (load_sequence_records(options.input_path, &collection) != 0) {
+        sequence_collection_free(&collection);
+        return EXIT_FAILURE;
+    }
+
+    if (collection.count == 0) {
+        fprintf(stderr, "No sequences were loaded from %s.\n", options.input_path);
+        sequence_collection_free(&collection);
+        return EXIT_FAILURE;
+    }
+
+    if (options.sort_key == SORT_KEY_CHROMOSOME) {
+        size_t unplaced = 0;
+        for (size_t i = 0; i < collection.count; ++i) {
+            unplaced += collection.records[i].contig == NULL;
+        }
+        if (unplaced == collection.count) {
+            fprintf(stderr, "--sort-by chromosome needs chromosome and start columns in %s.\n", options.input_path);
+            sequence_collection_free(&collection);
+            return EXIT_FAILURE;
+        }
+        if (unplaced > 0) {
+            fprintf(stderr, "%zu of %zu records have no chromosome/start and are written first.\n", unplaced,
+                    collection.count);
+        }
+    }
+
+    ReferenceGenome genome = {0};
+    const ReferenceGenome *reference = NULL;
+    if (options.reference_path) {
+        if (reference_genome_open(options.reference_path, &genome) != 0) {
+            sequence_collection_free(&collection);
+            return EXIT_FAILURE;
+        }
+        reference = &genome;
+    }
+    uint64_t run_started = latency_now_ns();
+
+    omp_set_num_threads(options.threads);
+
+    size_t elided_records = 0;
+    size_t total_records = collection.count;
+    size_t histogram_count = (size_t)omp_get_max_threads();
+    StageHistograms *histograms = NULL;
+    RecordTiming *timings = NULL;
+    if (options.latency_report) {
+        histograms = stage_histograms_create(histogram_count);
+    }
+    if (options.capture_trace) {
+        timings = (RecordTiming *)calloc(collection.count, sizeof(RecordTiming));
+    }
+    if ((options.latency_report && !histograms) || (options.capture_trace && !timings)) {
+        fprintf(stderr, "Failed to allocate latency histograms or trace timings.\n");
+        free(histograms);
+        free(timings);
+        reference_genome_close(&genome);
+        sequence_collection_free(&collection);
+        return EXIT_FAILURE;
+    }
+
+    if (options.sort_key != SORT_KEY_NONE) {
+        FILE *output = fopen(options.output_path, "w");
+        if (!output) {
+            fprintf(stderr, "Failed to open output file %s: %s\n", options.output_path, strerror(errno));
+            free(histograms);
+            free(timings);
+            reference_genome_close(&genome);
+            sequence_collection_free(&collection);
+            return EXIT_FAILURE;
+        }
+        fprintf(output, "record_id\tnonce_dna\tciphertext_dna\n");
+        int sort_status = write_sorted_output(&options, &collection, key, reference, output, &elided_records,
+                                              histograms, timings);
+        reference_genome_close(&genome);
+        if (fclose(output) != 0) {
+            sort_status = -1;
+        }
+        struct stat output_stat;
+        if (sort_status != 0 && stat(options.output_path, &output_stat) == 0 && S_ISREG(output_stat.st_mode)) {
+            /* Do not leave a truncated TSV that looks like a finished run. */
+            remove(options.output_path);
+        }
+        uint64_t run_finished = latency_now_ns();
+        if (reference) {
+            fprintf(stderr, "Elided reference bases for %zu of %zu records.\n", elided_records, total_records);
+        }
+        if (histograms) {
+            stage_histograms_report(histograms, histogram_count);
+            free(histograms);
+        }
+        if (sort_status == 0 && timings) {
+            sort_status = write_capture(&options, &collection, timings, run_started - load_started,
+                                        run_finished - run_started);
+        }
+        free(timings);
+        sequence_collection_free(&collection);
+        if (sort_status != 0) {
+            fprintf(stderr, "Aborting due to errors encountered while writing sorted output.\n");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    EncryptionResult *results = (EncryptionResult *)calloc(collection.count, sizeof(EncryptionResult));
+    if (!results) {
+        fprintf(stderr, "Failed to allocate memory for encryption results.\n");
+        free(histograms);
+        free(timings);
+        reference_genome_close(&genome);
+        sequence_collection_free(&collection);
+        return EXIT_FAILURE;
+    }
+
+    int encountered_error = encrypt_records(&collection, 0, total_records, key, reference, results, &elided_records,
+                                            histograms, timings) != 0;
+    reference_genome_close(&genome);
+
+    if (reference) {
+        fprintf(stderr, "Elided reference bases for %zu of %zu records.\n", elided_records, total_records);
+    }
+    if (histograms) {
+        stage_histograms_report(histograms, histogram_count);
+        free(histograms);
     }
 
     if (encountered_error) {
         fprintf(stderr, "Aborting due to errors encountered during encryption.\n");
+        free(timings);
         free_results(results, collection.count);
         sequence_collection_free(&collection);
         return EXIT_FAILURE;
@@ -313,6 +677,7 @@ int main(int argc, char **argv) {
     FILE *output = fopen(options.output_path, "w");
     if (!output) {
         fprintf(stderr, "Failed to open output file %s: %s\n", options.output_path, strerror(errno));
+        free(timings);
         free_results(results, collection.count);
         sequence_collection_free(&collection);
         return EXIT_FAILURE;
@@ -320,14 +685,17 @@ int main(int argc, char **argv) {
 
     fprintf(output, "record_id\tnonce_dna\tciphertext_dna\n");
     for (size_t i = 0; i < collection.count; ++i) {
-        const SequenceRecord *record = &collection.records[i];
-        EncryptionResult *result = &results[i];
-        const char *identifier = record->identifier ? record->identifier : "record";
-        fprintf(output, "%s\t%s\t%s\n", identifier, result->nonce_dna, result->ciphertext_dna);
+        write_row(output, &collection.records[i], &results[i]);
     }
 
     fclose(output);
     free_results(results, collection.count);
+    int status = EXIT_SUCCESS;
+    if (timings && write_capture(&options, &collection, timings, run_started - load_started,
+                                 latency_now_ns() - run_started) != 0) {
+        status = EXIT_FAILURE;
+    }
+    free(timings);
     sequence_collection_free(&collection);
-    return EXIT_SUCCESS;
+    return status;
 }
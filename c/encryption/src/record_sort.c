@@ -0,0 +1,329 @@
+/*
+ * Ordering of encrypted records for --sort-by. Small outputs are sorted in
+ * memory with a task-parallel merge sort; larger ones are spilled as sorted
+ * runs and k-way merged with one buffered line per run.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "record_sort.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define INSERTION_SORT_THRESHOLD 32
+#define PARALLEL_SORT_CUTOFF 8192
+/*
+ * Most runs open at once. Spilling merges the open runs into one whenever this
+ * many exist, so at most MAX_MERGE_FAN_IN + 1 run files are open at any time.
+ */
+#define MAX_MERGE_FAN_IN 32
+
+typedef struct {
+    const SequenceRecord *records;
+    SortKey key;
+} SortContext;
+
+int parse_sort_key(const char *name, SortKey *key) {
+    if (!name || !key) {
+        return -1;
+    }
+    if (strcasecmp(name, "chromosome") == 0 || strcasecmp(name, "chrom") == 0) {
+        *key = SORT_KEY_CHROMOSOME;
+        return 0;
+    }
+    if (strcasecmp(name, "record_id") == 0 || strcasecmp(name, "id") == 0) {
+        *key = SORT_KEY_RECORD_ID;
+        return 0;
+    }
+    return -1;
+}
+
+const char *sort_key_name(SortKey key) {
+    switch (key) {
+        case SORT_KEY_CHROMOSOME:
+            return "chromosome";
+        case SORT_KEY_RECORD_ID:
+            return "record_id";
+        default:
+            return "none";
+    }
+}
+
+static int compare_records(const SortContext *context, size_t a, size_t b) {
+    const SequenceRecord *left = &context->records[a];
+    const SequenceRecord *right = &context->records[b];
+    int order = 0;
+    if (context->key == SORT_KEY_CHROMOSOME) {
+        order = strcmp(left->contig ? left->contig : "", right->contig ? right->contig : "");
+        if (order == 0 && left->start != right->start) {
+            order = left->start < right->start ? -1 : 1;
+        }
+    } else if (context->key == SORT_KEY_RECORD_ID) {
+        order = strcmp(left->identifier ? left->identifier : "", right->identifier ? right->identifier : "");
+    }
+    if (order == 0 && a != b) {
+        order = a < b ? -1 : 1;
+    }
+    return order;
+}
+
+static void insertion_sort(size_t *order, size_t count, const SortContext *context) {
+    for (size_t i = 1; i < count; ++i) {
+        size_t value = order[i];
+        size_t j = i;
+        while (j > 0 && compare_records(context, order[j - 1], value) > 0) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = value;
+    }
+}
+
+static void merge_sort(size_t *order, size_t *scratch, size_t count, const SortContext *context) {
+    if (count <= INSERTION_SORT_THRESHOLD) {
+        insertion_sort(order, count, context);
+        return;
+    }
+    size_t half = count / 2;
+#pragma omp task if (count > PARALLEL_SORT_CUTOFF)
+    merge_sort(order, scratch, half, context);
+#pragma omp task if (count > PARALLEL_SORT_CUTOFF)
+    merge_sort(order + half, scratch + half, count - half, context);
+#pragma omp taskwait
+
+    size_t left = 0;
+    size_t right = half;
+    size_t out = 0;
+    while (left < half && right < count) {
+        if (compare_records(context, order[left], order[right]) <= 0) {
+            scratch[out++] = order[left++];
+        } else {
+            scratch[out++] = order[right++];
+        }
+    }
+    while (left < half) {
+        scratch[out++] = order[left++];
+    }
+    while (right < count) {
+        scratch[out++] = order[right++];
+    }
+    memcpy(order, scratch, count * sizeof(size_t));
+}
+
+int sort_record_order(const SequenceRecord *records, size_t begin, size_t count, SortKey key, size_t *order) {
+    if (!records || !order) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = begin + i;
+    }
+    if (key == SORT_KEY_NONE || count < 2) {
+        return 0;
+    }
+    size_t *scratch = (size_t *)malloc(count * sizeof(size_t));
+    if (!scratch) {
+        return -1;
+    }
+    SortContext context = {records, key};
+#pragma omp parallel
+#pragma omp single
+    merge_sort(order, scratch, count, &context);
+    free(scratch);
+    return 0;
+}
+
+void sort_runs_init(SortRuns *runs) {
+    if (!runs) {
+        return;
+    }
+    runs->files = NULL;
+    runs->count = 0;
+    runs->capacity = 0;
+}
+
+void sort_runs_free(SortRuns *runs) {
+    if (!runs) {
+        return;
+    }
+    for (size_t i = 0; i < runs->count; ++i) {
+        if (runs->files[i]) {
+            fclose(runs->files[i]);
+        }
+    }
+    free(runs->files);
+    runs->files = NULL;
+    runs->count = 0;
+    runs->capacity = 0;
+}
+
+static int sort_runs_append(SortRuns *runs, FILE *file) {
+    if (runs->count == runs->capacity) {
+        size_t new_capacity = runs->capacity == 0 ? 16 : runs->capacity * 2;
+        FILE **resized = (FILE **)realloc(runs->files, new_capacity * sizeof(FILE *));
+        if (!resized) {
+            return -1;
+        }
+        runs->files = resized;
+        runs->capacity = new_capacity;
+    }
+    runs->files[runs->count++] = file;
+    return 0;
+}
+
+static int merge_files(FILE **files, size_t count, FILE *output, int strip_keys);
+
+/* Merges every open run into a single run, keeping its key prefixes. */
+static int sort_runs_compact(SortRuns *runs) {
+    FILE *target = tmpfile();
+    if (!target) {
+        fprintf(stderr, "Failed to create a temporary sort run.\n");
+        return -1;
+    }
+    if (merge_files(runs->files, runs->count, target, 0) != 0) {
+        fclose(target);
+        return -1;
+    }
+    for (size_t i = 0; i < runs->count; ++i) {
+        fclose(runs->files[i]);
+    }
+    runs->files[0] = target;
+    runs->count = 1;
+    return 0;
+}
+
+FILE *sort_runs_begin(SortRuns *runs) {
+    if (!runs) {
+        return NULL;
+    }
+    /*
+     * Every tmpfile() stays open until it is merged, so cascade before opening
+     * another run. The first run grows with each cascade; with the default
+     * --sort-memory budget a cascade is rare.
+     */
+    if (runs->count >= MAX_MERGE_FAN_IN && sort_runs_compact(runs) != 0) {
+        return NULL;
+    }
+    FILE *file = tmpfile();
+    if (!file) {
+        fprintf(stderr, "Failed to create a temporary sort run.\n");
+        return NULL;
+    }
+    if (sort_runs_append(runs, file) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+/*
+ * Keys are fields joined by '\x01', which sorts below every printable
+ * character, with zero-padded numbers. Comparing whole run lines with strcmp
+ * therefore matches compare_records; the trailing input index keeps keys
+ * unique so the comparison never reaches the row itself.
+ */
+int sort_runs_write_key(FILE *run, const SequenceRecord *records, size_t index, SortKey key) {
+    if (!run || !records) {
+        return -1;
+    }
+    const SequenceRecord *record = &records[index];
+    int written = 0;
+    if (key == SORT_KEY_CHROMOSOME) {
+        written = fprintf(run, "%s\x01%020zu\x01%020zu\t", record->contig ? record->contig : "", record->start, index);
+    } else {
+        written = fprintf(run, "%s\x01%020zu\t", record->identifier ? record->identifier : "", index);
+    }
+    return written < 0 ? -1 : 0;
+}
+
+typedef struct {
+    FILE *file;
+    char *line;
+    size_t size;
+} RunCursor;
+
+static int cursor_advance(RunCursor *cursor) {
+    return getline(&cursor->line, &cursor->size, cursor->file) < 0 ? 0 : 1;
+}
+
+static void heap_sift_down(RunCursor **heap, size_t count, size_t index) {
+    for (;;) {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = left + 1;
+        if (left < count && strcmp(heap[left]->line, heap[smallest]->line) < 0) {
+            smallest = left;
+        }
+        if (right < count && strcmp(heap[right]->line, heap[smallest]->line) < 0) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            return;
+        }
+        RunCursor *swap = heap[index];
+        heap[index] = heap[smallest];
+        heap[smallest] = swap;
+        index = smallest;
+    }
+}
+
+/* Merges `count` runs into `output`, keeping or stripping the key prefix. */
+static int merge_files(FILE **files, size_t count, FILE *output, int strip_keys) {
+    RunCursor *cursors = (RunCursor *)calloc(count, sizeof(RunCursor));
+    RunCursor **heap = (RunCursor **)calloc(count, sizeof(RunCursor *));
+    if (!cursors || !heap) {
+        free(cursors);
+        free(heap);
+        return -1;
+    }
+    size_t heap_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        cursors[i].file = files[i];
+        rewind(files[i]);
+        if (cursor_advance(&cursors[i])) {
+            heap[heap_count++] = &cursors[i];
+        }
+    }
+    for (size_t i = heap_count; i-- > 0;) {
+        heap_sift_down(heap, heap_count, i);
+    }
+
+    int status = 0;
+    while (heap_count > 0) {
+        RunCursor *top = heap[0];
+        const char *row = top->line;
+        if (strip_keys) {
+            const char *tab = strchr(row, '\t');
+            row = tab ? tab + 1 : row;
+        }
+        if (fputs(row, output) < 0) {
+            status = -1;
+            break;
+        }
+        if (!cursor_advance(top)) {
+            heap[0] = heap[--heap_count];
+        }
+        heap_sift_down(heap, heap_count, 0);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        free(cursors[i].line);
+    }
+    free(cursors);
+    free(heap);
+    return status;
+}
+
+int sort_runs_merge(SortRuns *runs, FILE *output) {
+    if (!runs || !output) {
+        return -1;
+    }
+    /* sort_runs_begin keeps runs->count <= MAX_MERGE_FAN_IN, so one pass suffices. */
+    if (runs->count == 0) {
+        return 0;
+    }
+    return merge_files(runs->files, runs->count, output, 1);
+}
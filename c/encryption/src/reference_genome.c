@@ -0,0 +1,217 @@
+/*
+ * Read-only access to a memory-mapped reference genome (FASTA). Used to elide
+ * reference bases from plaintexts: a record only needs its contig and interval
+ * when the bases can be re-materialized from the same reference.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "reference_genome.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int append_contig(ReferenceGenome *genome, size_t *capacity, ReferenceContig contig) {
+    if (genome->count == *capacity) {
+        size_t new_capacity = *capacity == 0 ? 16 : *capacity * 2;
+        ReferenceContig *resized =
+            (ReferenceContig *)realloc(genome->contigs, new_capacity * sizeof(ReferenceContig));
+        if (!resized) {
+            return -1;
+        }
+        genome->contigs = resized;
+        *capacity = new_capacity;
+    }
+    genome->contigs[genome->count++] = contig;
+    return 0;
+}
+
+/* Scans one contig body starting at `cursor`, filling in its layout. Returns the next header offset. */
+static int index_contig(const char *data, size_t size, size_t cursor, ReferenceContig *contig, size_t *next) {
+    int short_line_seen = 0;
+    contig->offset = cursor;
+    contig->length = 0;
+    contig->line_bases = 0;
+    contig->line_bytes = 0;
+    while (cursor < size && data[cursor] != '>') {
+        const char *newline = (const char *)memchr(data + cursor, '\n', size - cursor);
+        size_t line_end = newline ? (size_t)(newline - data) + 1 : size;
+        size_t bases = (newline ? (size_t)(newline - data) : size) - cursor;
+        if (bases > 0 && data[cursor + bases - 1] == '\r') {
+            bases--;
+        }
+        if (bases > 0) {
+            if (short_line_seen) {
+                return -1;
+            }
+            if (contig->line_bases == 0) {
+                contig->line_bases = bases;
+                contig->line_bytes = line_end - cursor;
+            } else if (bases > contig->line_bases) {
+                return -1;
+            }
+            if (bases < contig->line_bases || line_end - cursor != contig->line_bytes) {
+                short_line_seen = 1;
+            }
+            contig->length += bases;
+        } else {
+            short_line_seen = 1;
+        }
+        cursor = line_end;
+    }
+    *next = cursor;
+    return 0;
+}
+
+int reference_genome_open(const char *path, ReferenceGenome *genome) {
+    if (!path || !genome) {
+        return -1;
+    }
+    genome->data = NULL;
+    genome->size = 0;
+    genome->contigs = NULL;
+    genome->count = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open reference %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        fprintf(stderr, "Reference %s is empty or unreadable.\n", path);
+        close(fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Failed to map reference %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    genome->data = (const char *)mapping;
+    genome->size = (size_t)info.st_size;
+
+    size_t capacity = 0;
+    size_t cursor = 0;
+    while (cursor < genome->size) {
+        if (genome->data[cursor] != '>') {
+            fprintf(stderr, "Reference %s is not a FASTA file.\n", path);
+            reference_genome_close(genome);
+            return -1;
+        }
+        size_t name_start = cursor + 1;
+        size_t name_end = name_start;
+        while (name_end < genome->size && !isspace((unsigned char)genome->data[name_end])) {
+            name_end++;
+        }
+        const char *header_end = (const char *)memchr(genome->data + name_end, '\n', genome->size - name_end);
+        cursor = header_end ? (size_t)(header_end - genome->data) + 1 : genome->size;
+
+        ReferenceContig contig = {0};
+        size_t next = cursor;
+        if (index_contig(genome->data, genome->size, cursor, &contig, &next) != 0) {
+            fprintf(stderr, "Reference %s has irregular line lengths in contig %.*s.\n", path,
+                    (int)(name_end - name_start), genome->data + name_start);
+            reference_genome_close(genome);
+            return -1;
+        }
+        contig.name = (char *)malloc(name_end - name_start + 1);
+        if (!contig.name) {
+            reference_genome_close(genome);
+            return -1;
+        }
+        memcpy(contig.name, genome->data + name_start, name_end - name_start);
+        contig.name[name_end - name_start] = '\0';
+        if (append_contig(genome, &capacity, contig) != 0) {
+            free(contig.name);
+            reference_genome_close(genome);
+            return -1;
+        }
+        cursor = next;
+    }
+    return 0;
+}
+
+void reference_genome_close(ReferenceGenome *genome) {
+    if (!genome) {
+        return;
+    }
+    for (size_t i = 0; i < genome->count; ++i) {
+        free(genome->contigs[i].name);
+    }
+    free(genome->contigs);
+    if (genome->data) {
+        munmap((void *)genome->data, genome->size);
+    }
+    genome->data = NULL;
+    genome->size = 0;
+    genome->contigs = NULL;
+    genome->count = 0;
+}
+
+const ReferenceContig *reference_genome_find(const ReferenceGenome *genome, const char *name) {
+    if (!genome || !name) {
+        return NULL;
+    }
+    for (size_t i = 0; i < genome->count; ++i) {
+        if (strcmp(genome->contigs[i].name, name) == 0) {
+            return &genome->contigs[i];
+        }
+    }
+    return NULL;
+}
+
+static const ReferenceContig *locate_interval(const ReferenceGenome *genome, const char *contig, size_t start,
+                                              size_t end) {
+    const ReferenceContig *entry = reference_genome_find(genome, contig);
+    if (!entry || start >= end || end > entry->length) {
+        return NULL;
+    }
+    return entry;
+}
+
+static char base_at(const ReferenceGenome *genome, const ReferenceContig *contig, size_t position) {
+    size_t offset = contig->offset + (position / contig->line_bases) * contig->line_bytes +
+                    position % contig->line_bases;
+    return genome->data[offset];
+}
+
+int reference_genome_matches(const ReferenceGenome *genome, const char *contig, size_t start, size_t end,
+                             const char *bases) {
+    const ReferenceContig *entry = locate_interval(genome, contig, start, end);
+    if (!entry || !bases || strlen(bases) != end - start) {
+        return 0;
+    }
+    for (size_t i = start; i < end; ++i) {
+        if (base_at(genome, entry, i) != bases[i - start]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+char *reference_genome_fetch(const ReferenceGenome *genome, const char *contig, size_t start, size_t end) {
+    const ReferenceContig *entry = locate_interval(genome, contig, start, end);
+    if (!entry) {
+        return NULL;
+    }
+    char *bases = (char *)malloc(end - start + 1);
+    if (!bases) {
+        return NULL;
+    }
+    for (size_t i = start; i < end; ++i) {
+        bases[i - start] = base_at(genome, entry, i);
+    }
+    bases[end - start] = '\0';
+    return bases;
+}
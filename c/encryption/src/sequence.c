@@ -37,10 +37,12 @@ static void free_record(SequenceRecord *record) {
     free(record->positions);
     free(record->reference);
     free(record->sequence);
+    free(record->contig);
     record->identifier = NULL;
     record->positions = NULL;
     record->reference = NULL;
     record->sequence = NULL;
+    record->contig = NULL;
 }
 
 static char *trim(char *value) {
@@ -199,9 +201,32 @@ static int locate_column(const char *name) {
         strcasecmp(name, "sequence") == 0 || strcasecmp(name, "dna_string") == 0) {
         return 3;
     }
+    if (strcasecmp(name, "chromosome") == 0 || strcasecmp(name, "chrom") == 0 || strcasecmp(name, "contig") == 0) {
+        return 4;
+    }
+    if (strcasecmp(name, "start") == 0) {
+        return 5;
+    }
+    if (strcasecmp(name, "end") == 0) {
+        return 6;
+    }
     return -1;
 }
 
+static int parse_coordinate(const char *value, size_t *out) {
+    if (!value || *value == '\0') {
+        return -1;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || *end != '\0' || value[0] == '-') {
+        return -1;
+    }
+    *out = (size_t)parsed;
+    return 0;
+}
+
 int load_sequence_records(const char *path, SequenceCollection *collection) {
     if (!path || !collection) {
         return -1;
@@ -236,6 +261,9 @@ int load_sequence_records(const char *path, SequenceCollection *collection) {
     int positions_index = -1;
     int reference_index = -1;
     int sequence_index = -1;
+    int contig_index = -1;
+    int start_index = -1;
+    int end_index = -1;
     for (size_t i = 0; i < header_count; ++i) {
         int column_type = locate_column(header_columns[i]);
         switch (column_type) {
@@ -251,6 +279,15 @@ int load_sequence_records(const char *path, SequenceCollection *collection) {
             case 3:
                 sequence_index = (int)i;
                 break;
+            case 4:
+                contig_index = (int)i;
+                break;
+            case 5:
+                start_index = (int)i;
+                break;
+            case 6:
+                end_index = (int)i;
+                break;
             default:
                 break;
         }
@@ -302,6 +339,25 @@ int load_sequence_records(const char *path, SequenceCollection *collection) {
         if ((size_t)sequence_index < column_count) {
             record.sequence = duplicate_string(trim(columns[sequence_index]));
         }
+        /*
+         * contig and start are enough for --sort-by chromosome; an interval
+         * usable for reference elision additionally needs end > start.
+         */
+        if (contig_index >= 0 && start_index >= 0 && (size_t)contig_index < column_count &&
+            (size_t)start_index < column_count) {
+            const char *contig = trim(columns[contig_index]);
+            size_t start = 0;
+            if (*contig != '\0' && parse_coordinate(trim(columns[start_index]), &start) == 0) {
+                size_t end = 0;
+                record.contig = duplicate_string(contig);
+                record.start = start;
+                record.end = start;
+                if (end_index >= 0 && (size_t)end_index < column_count &&
+                    parse_coordinate(trim(columns[end_index]), &end) == 0 && end > start) {
+                    record.end = end;
+                }
+            }
+        }
         free_columns(columns);
 
         if (!record.sequence || record.sequence[0] == '\0') {
@@ -0,0 +1,155 @@
+/*
+ * Sanitized workload capture for --capture-trace. The trace keeps the shape
+ * of a production run (record size mix, column presence, options, per-record
+ * stage timings and thread interleaving) without any of its content, so it
+ * can be handed to performance testing and replayed on synthetic data.
+ */
+
+#include "workload_trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WORKLOAD_TRACE_VERSION 2
+
+typedef struct {
+    const char *contig;
+    size_t start;
+    size_t index;
+} IntervalKey;
+
+static int compare_interval_keys(const void *a, const void *b) {
+    const IntervalKey *left = (const IntervalKey *)a;
+    const IntervalKey *right = (const IntervalKey *)b;
+    int order = strcmp(left->contig, right->contig);
+    if (order == 0 && left->start != right->start) {
+        order = left->start < right->start ? -1 : 1;
+    }
+    if (order == 0 && left->index != right->index) {
+        order = left->index < right->index ? -1 : 1;
+    }
+    return order;
+}
+
+/*
+ * Ranks records by interval without keeping names or coordinates: the contig
+ * rank follows the name order used by --sort-by chromosome, and the start
+ * rank is the dense rank of the start within its contig (equal starts share a
+ * rank). Records without an interval get -1.
+ */
+static int rank_intervals(const SequenceCollection *collection, long *contig_ranks, long *start_ranks) {
+    IntervalKey *keys = (IntervalKey *)malloc((collection->count > 0 ? collection->count : 1) * sizeof(IntervalKey));
+    if (!keys) {
+        return -1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < collection->count; ++i) {
+        const SequenceRecord *record = &collection->records[i];
+        contig_ranks[i] = -1;
+        start_ranks[i] = -1;
+        if (record->contig) {
+            keys[count].contig = record->contig;
+            keys[count].start = record->start;
+            keys[count].index = i;
+            count++;
+        }
+    }
+    qsort(keys, count, sizeof(IntervalKey), compare_interval_keys);
+    long contig = -1;
+    long start = 0;
+    for (size_t k = 0; k < count; ++k) {
+        if (k == 0 || strcmp(keys[k].contig, keys[k - 1].contig) != 0) {
+            contig++;
+            start = 0;
+        } else if (keys[k].start != keys[k - 1].start) {
+            start++;
+        }
+        contig_ranks[keys[k].index] = contig;
+        start_ranks[keys[k].index] = start;
+    }
+    free(keys);
+    return 0;
+}
+
+/* Writes a length, or "-" when the field is absent. */
+static void write_length(FILE *file, const char *value) {
+    if (value) {
+        fprintf(file, "\t%zu", strlen(value));
+    } else {
+        fputs("\t-", file);
+    }
+}
+
+int workload_trace_write(const char *path, const WorkloadTraceSettings *settings,
+                         const SequenceCollection *collection, const RecordTiming *timings) {
+    if (!path || !settings || !collection || !timings) {
+        return -1;
+    }
+    long *contig_ranks = (long *)malloc((collection->count > 0 ? collection->count : 1) * sizeof(long));
+    long *start_ranks = (long *)malloc((collection->count > 0 ? collection->count : 1) * sizeof(long));
+    if (!contig_ranks || !start_ranks || rank_intervals(collection, contig_ranks, start_ranks) != 0) {
+        fprintf(stderr, "Failed to allocate memory for trace file %s.\n", path);
+        free(contig_ranks);
+        free(start_ranks);
+        return -1;
+    }
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Failed to open trace file %s: %s\n", path, strerror(errno));
+        free(contig_ranks);
+        free(start_ranks);
+        return -1;
+    }
+
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < collection->count; ++i) {
+        if (timings[i].start_ns != 0 && timings[i].start_ns < origin) {
+            origin = timings[i].start_ns;
+        }
+    }
+
+    fprintf(file, "#workload-trace\t%d\n", WORKLOAD_TRACE_VERSION);
+    fprintf(file, "option\tthreads\t%d\n", settings->threads);
+    fprintf(file, "option\tsort_by\t%s\n", settings->sort_by ? settings->sort_by : "none");
+    fprintf(file, "option\tsort_memory_mb\t%zu\n", settings->sort_memory_mb);
+    fprintf(file, "option\treference_fasta\t%d\n", settings->reference_fasta);
+    fprintf(file, "option\tlatency_report\t%d\n", settings->latency_report);
+    fprintf(file, "phase\tload_ns\t%llu\n", (unsigned long long)settings->load_ns);
+    fprintf(file, "phase\trun_ns\t%llu\n", (unsigned long long)settings->run_ns);
+    fprintf(file, "#record\tid_len\tpositions_len\treference_len\tsequence_len\tcontig\tstart_rank\tinterval_len\telided"
+                  "\tthread\tstart_ns\tplaintext_ns\tcipher_ns\tencode_ns\tplaintext_bytes\n");
+
+    int status = 0;
+    for (size_t i = 0; i < collection->count && status == 0; ++i) {
+        const SequenceRecord *record = &collection->records[i];
+        const RecordTiming *timing = &timings[i];
+        fputs("record", file);
+        write_length(file, record->identifier);
+        write_length(file, record->positions);
+        write_length(file, record->reference);
+        write_length(file, record->sequence);
+        if (record->contig) {
+            fprintf(file, "\t%ld\t%ld\t%zu", contig_ranks[i], start_ranks[i], record->end - record->start);
+        } else {
+            fputs("\t-\t-\t-", file);
+        }
+        uint64_t start = timing->start_ns >= origin ? timing->start_ns - origin : 0;
+        if (fprintf(file, "\t%d\t%d\t%llu\t%llu\t%llu\t%llu\t%zu\n", timing->elided, timing->thread,
+                    (unsigned long long)start, (unsigned long long)timing->plaintext_ns,
+                    (unsigned long long)timing->cipher_ns, (unsigned long long)timing->encode_ns,
+                    timing->plaintext_bytes) < 0) {
+            status = -1;
+        }
+    }
+    free(contig_ranks);
+    free(start_ranks);
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Failed to write trace file %s.\n", path);
+    }
+    return status;
+}
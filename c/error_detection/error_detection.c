@@ -10,8 +10,8 @@
  */
 
 #include "error_detection.h"
+#include "dna_transform.h"
 
-#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,6 +39,12 @@ static char digit_to_base(int digit) {
     return mapping[digit];
 }
 
+// stored blocks are upper-case only, so detection rejects lower-case bases
+static const unsigned char stored_codes[256] = {
+    [DNA_BASE_A] = 1, [DNA_BASE_T] = 2, [DNA_BASE_G] = 3, [DNA_BASE_C] = 4,
+};
+static const DnaAlphabet stored_alphabet = {stored_codes, "ATGC"};
+
 // helper to free a partially allocated block in case of error
 static void free_partial_block(char **block, size_t allocated_rows) {
     if (!block) {
@@ -91,41 +97,35 @@ char **build_parity_block(const char **rows,
         }
     }
 
+    // column sums are accumulated while the rows are copied
+    size_t *column_sums = calloc(row_length, sizeof(size_t));
+    if (!column_sums) {
+        free_partial_block(block, total_rows);
+        return NULL;
+    }
+
     size_t total_sum = 0;
 
-    // copy data and compute row parities
+    // copy, uppercase, validate and sum each row in a single sweep
     for (size_t i = 0; i < row_count; ++i) {
-        size_t row_sum = 0;
-        for (size_t j = 0; j < row_length; ++j) {
-            if (!rows[i]) {
-                free_partial_block(block, total_rows);
-                return NULL;
-            }
-            // convert to uppercase and validate base
-            char base = (char)toupper((unsigned char)rows[i][j]);
-            if (base_to_digit(base) < 0) {
-                free_partial_block(block, total_rows);
-                return NULL;
-            }
-            block[i][j] = base;
-            // accumulate row sum
-            row_sum += (size_t)base_to_digit(base);
+        DnaPassOutput pass = {.bases = block[i], .column_sums = column_sums};
+        if (dna_fused_pass(DNA_PASS_NORMALIZE | DNA_PASS_VALIDATE | DNA_PASS_CHECKSUM | DNA_PASS_COLUMNS,
+                           &DNA_ALPHABET_ATGC, rows[i], row_length, &pass) != 0) {
+            free(column_sums);
+            free_partial_block(block, total_rows);
+            return NULL;
         }
         // accumulate total sum
-        total_sum += row_sum;
+        total_sum += pass.checksum;
         // set row parity nucleotide
-        block[i][row_length] = digit_to_base((int)(row_sum % 4));
+        block[i][row_length] = digit_to_base((int)(pass.checksum % 4));
     }
 
-    // compute column parities
+    // set column parities
     for (size_t j = 0; j < row_length; ++j) {
-        size_t column_sum = 0;
-        for (size_t i = 0; i < row_count; ++i) {
-            // for each data column j, sum digits down rows i=0..row_count-1
-            column_sum += (size_t)base_to_digit(block[i][j]);
-        }
-        block[row_count][j] = digit_to_base((int)(column_sum % 4));
+        block[row_count][j] = digit_to_base((int)(column_sums[j] % 4));
     }
+    free(column_sums);
 
     block[row_count][row_length] = digit_to_base((int)(total_sum % 4));
 
@@ -207,15 +207,13 @@ int detect_and_correct_parity_block(char **block,
 
     // for each data cell (i,j), add digit to row_sums[i] and col_sums[j]
     for (size_t i = 0; i < data_rows; ++i) {
-        for (size_t j = 0; j < data_cols; ++j) {
-            int digit = base_to_digit(block[i][j]);
-            // if any base invalid, return PARITY_INVALID_INPUT
-            if (digit < 0) {
-                goto cleanup_invalid;
-            }
-            row_sums[i] += (size_t)digit;
-            col_sums[j] += (size_t)digit;
+        DnaPassOutput pass = {.column_sums = col_sums};
+        // if any base invalid, return PARITY_INVALID_INPUT
+        if (dna_fused_pass(DNA_PASS_VALIDATE | DNA_PASS_CHECKSUM | DNA_PASS_COLUMNS, &stored_alphabet, block[i],
+                           data_cols, &pass) != 0) {
+            goto cleanup_invalid;
         }
+        row_sums[i] = pass.checksum;
         // sums rows mod 4
         row_expected[i] = (int)(row_sums[i] % 4);
         // read stored row parity from block